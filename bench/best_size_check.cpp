@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string_view>
+
+#include "orderbook.hpp"
+#include "utils.hpp"
+
+/// @brief Default number of random book pairs
+const int kDefaultCases = 20000;
+
+/// @brief Most levels per generated side, so every order size can be tried
+const int kMaxCheckLevels = 12;
+
+/// @brief Largest level quantity generated, in lots
+const Lots kMaxCheckLots = 40;
+
+/**
+ * @brief Builds one random side pair around a mid price
+ *
+ * Asks rise and bids fall by 1-5 ticks per level from a best ask of
+ * 10000 ticks, and the best bid lies 20 ticks below to 60 above it, so
+ * against fees of up to 30 ticks pairs range from far apart to crossed
+ * through every level. Quantities stay small enough that every order
+ * size up to the smaller side can be evaluated directly.
+ *
+ * @return Order size limit in lots, sometimes inside the books
+ */
+Lots buildPair(L2OrderBook& buy, L2OrderBook& sell, std::mt19937_64& rng) {
+    buy = {};
+    sell = {};
+    buy.scale = sell.scale = kDefaultScale;
+    std::uniform_int_distribution<int> levels(1, kMaxCheckLevels);
+    std::uniform_int_distribution<Lots> lots(1, kMaxCheckLots);
+    std::uniform_int_distribution<Ticks> step(1, 5);
+
+    Ticks ask = 10000;
+    Ticks bid = ask + std::uniform_int_distribution<Ticks>(-20, 60)(rng);
+    buy.askSize = levels(rng);
+    sell.bidSize = levels(rng);
+    for (int i = 0; i < buy.askSize; i++) {
+        buy.askPrice[i] = ask;
+        buy.askQuantity[i] = lots(rng);
+        ask += step(rng);
+    }
+    for (int i = 0; i < sell.bidSize; i++) {
+        sell.bidPrice[i] = bid;
+        sell.bidQuantity[i] = lots(rng);
+        bid -= step(rng);
+    }
+    return rng() % 4 == 0 ? std::uniform_int_distribution<Lots>(1, 3 * kMaxCheckLots)(rng)
+                          : kMaxCheckLevels * kMaxCheckLots;
+}
+
+/// @brief Cost of taking q lots from the first levels of a side, in ticks * lots
+Notional takeLevels(const Ticks* price, const Lots* quantity, int size, Lots q) {
+    Notional total = 0;
+    for (int i = 0; i < size && q > 0; i++) {
+        Lots take = std::min(q, quantity[i]);
+        total += take * price[i];
+        q -= take;
+    }
+    return total;
+}
+
+/// @brief Net profit of size q scaled by kFeeDen, from the raw levels
+__int128 profitAt(const L2OrderBook& buy, const L2OrderBook& sell, int64_t fee, Lots q) {
+    Notional cost = takeLevels(buy.askPrice, buy.askQuantity, buy.askSize, q);
+    Notional rev = takeLevels(sell.bidPrice, sell.bidQuantity, sell.bidSize, q);
+    return __int128(rev) * kFeeDen - __int128(cost) * (kFeeDen + fee);
+}
+
+/**
+ * @brief Brute-force check of solveBestSize()
+ *
+ * Usage: arb_best_size_check [--cases N] [--seed S]
+ *
+ * For random book pairs, evaluates net profit at every order size from
+ * one lot to the smaller side (capped at the order size limit) straight
+ * from the raw levels, and requires solveBestSize() to report the smallest
+ * size reaching the maximum, with the same profit, or nothing when no size
+ * is profitable. Every point of the requested profit curve is checked
+ * against the same direct evaluation. Exits non-zero on the first mismatch.
+ */
+int main(int argc, char** argv) {
+    int cases = kDefaultCases;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--cases" && i + 1 < argc) {
+            cases = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--cases N] [--seed S]\n";
+            return 1;
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> fee_pct(0.0, 0.3);
+    auto buy = std::make_unique<L2OrderBook>();
+    auto sell = std::make_unique<L2OrderBook>();
+    const double qty_unit = static_cast<double>(kPow10[kDefaultScale.qty_decimals]);
+    const double profit_unit = static_cast<double>(kPow10[kDefaultScale.price_decimals + kDefaultScale.qty_decimals]) * kFeeDen;
+    ProfitPoint curve[kMaxCurvePoints];
+    uint64_t profitable = 0, sizes = 0, points = 0;
+
+    for (int c = 0; c < cases; c++) {
+        Lots max_lots = buildPair(*buy, *sell, rng);
+        computeDepth(*buy, max_lots);
+        computeDepth(*sell, max_lots);
+        int64_t fee = feeUnits(fee_pct(rng));
+
+        Lots ask_lots = 0, bid_lots = 0;
+        for (int i = 0; i < buy->askSize; i++)
+            ask_lots += buy->askQuantity[i];
+        for (int i = 0; i < sell->bidSize; i++)
+            bid_lots += sell->bidQuantity[i];
+        Lots limit = std::min({ask_lots, bid_lots, max_lots});
+
+        Lots best_q = 0;
+        __int128 best_profit = 0;
+        for (Lots q = 1; q <= limit; q++) {
+            __int128 profit = profitAt(*buy, *sell, fee, q);
+            if (profit > best_profit) {
+                best_q = q;
+                best_profit = profit;
+            }
+        }
+        sizes += limit;
+
+        Opportunity opp{};
+        int n = 0;
+        bool found = solveBestSize(*buy, *sell, fee, 0.0, opp, curve, &n);
+        bool match = found == (best_q > 0);
+        if (match && found) {
+            profitable++;
+            match = std::llround(opp.order_size * qty_unit) == best_q &&
+                    opp.net_profit == static_cast<double>(best_profit) / profit_unit;
+        }
+        for (int i = 0; match && i < n; i++) {
+            Lots q = std::llround(curve[i].size * qty_unit);
+            match = q >= 1 && q <= limit &&
+                    curve[i].net_profit == static_cast<double>(profitAt(*buy, *sell, fee, q)) / profit_unit;
+            points++;
+        }
+
+        if (!match) {
+            std::cout << "MISMATCH on case " << c << ": fee " << fee << "/" << kFeeDen << ", max_lots " << max_lots
+                      << "\n  brute force: size " << best_q << " lots, profit "
+                      << static_cast<double>(best_profit) / profit_unit
+                      << "\n  solver: " << (found ? "size " : "nothing, size ") << opp.order_size * qty_unit
+                      << " lots, profit " << opp.net_profit << ", " << n << " curve points\n  asks:";
+            for (int i = 0; i < buy->askSize; i++)
+                std::cout << " " << buy->askQuantity[i] << "@" << buy->askPrice[i];
+            std::cout << "\n  bids:";
+            for (int i = 0; i < sell->bidSize; i++)
+                std::cout << " " << sell->bidQuantity[i] << "@" << sell->bidPrice[i];
+            std::cout << "\n";
+            return 1;
+        }
+    }
+
+    std::cout << cases << " book pairs (" << profitable << " profitable), " << sizes
+              << " order sizes and " << points << " curve points match brute force\n";
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "depth_kernels.hpp"
+
+/// @brief Default number of random book sides per kernel
+const int kDefaultCases = 200000;
+
+/// @brief Longest side generated; covers several full vectors plus a tail
+const int kMaxCheckLevels = 67;
+
+/// @brief One kernel under test
+struct KernelUnderTest {
+    const char* name;     ///< Name printed in the report
+    DepthKernel kernel;   ///< Entry point
+    bool supported;       ///< Whether the running CPU can execute it
+};
+
+/**
+ * @brief Fills one random book side
+ *
+ * Half the sides keep every quantity and price under 32 bits, the AVX2
+ * fast path; the other half mix in wide quantities so the vector kernels
+ * hand over to the scalar tail mid-side. Ranges are chosen so no prefix
+ * notional can overflow, which is what computeDepth()'s scales guarantee.
+ * Some quantities are zero, as venues send for removed levels.
+ *
+ * @return Order size limit for the side: zero, inside the side, exactly
+ *         at a level boundary or past the whole side
+ */
+int64_t buildSide(std::vector<int64_t>& qty, std::vector<int64_t>& price, int size, std::mt19937_64& rng) {
+    bool wide = rng() & 1;
+    std::uniform_int_distribution<int64_t> quantity(0, wide ? (int64_t{1} << 36) : (int64_t{1} << 20));
+    std::uniform_int_distribution<int64_t> tick(1, wide ? (int64_t{1} << 20) : (int64_t{1} << 31) - 1);
+    qty.resize(size);
+    price.resize(size);
+    int64_t total = 0;
+    for (int i = 0; i < size; i++) {
+        qty[i] = rng() % 8 == 0 ? 0 : quantity(rng);
+        price[i] = tick(rng);
+        total += qty[i];
+    }
+
+    switch (rng() % 4) {
+    case 0:
+        return rng() % 8 == 0 ? 0 : 1;
+    case 1: {
+        int64_t boundary = 0;
+        int last = static_cast<int>(rng() % kMaxCheckLevels);
+        for (int i = 0; i < size && i <= last; i++)
+            boundary += qty[i];
+        return std::max<int64_t>(boundary, 1);
+    }
+    case 2:
+        return total + 1 + static_cast<int64_t>(rng() % 1000);
+    default:
+        return std::uniform_int_distribution<int64_t>(1, std::max<int64_t>(total, 1))(rng);
+    }
+}
+
+/**
+ * @brief Randomized equivalence check of the depth kernels
+ *
+ * Usage: arb_depth_check [--cases N] [--seed S]
+ *
+ * Runs every kernel the CPU supports on the same random book sides as
+ * depthKernelScalar() and requires identical output: the same number of
+ * levels and bit-equal cumulative quantities and notionals. Sizes run from
+ * empty to past several vectors so every tail length is hit. Exits non-zero
+ * on the first mismatch, after printing the failing case.
+ */
+int main(int argc, char** argv) {
+    int cases = kDefaultCases;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--cases" && i + 1 < argc) {
+            cases = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--cases N] [--seed S]\n";
+            return 1;
+        }
+    }
+
+    bool avx2 = false, avx512 = false;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    avx2 = __builtin_cpu_supports("avx2");
+    avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+#endif
+    const KernelUnderTest kernels[] = {
+        {"avx2", depthKernelAvx2, avx2},
+        {"avx512", depthKernelAvx512, avx512},
+    };
+
+    std::vector<int64_t> qty, price;
+    int64_t ref_qty[kMaxCheckLevels] = {}, ref_cost[kMaxCheckLevels] = {};
+    int64_t got_qty[kMaxCheckLevels] = {}, got_cost[kMaxCheckLevels] = {};
+    std::cout << "selected kernel: " << depthKernelName() << "\n";
+
+    for (const KernelUnderTest& k : kernels) {
+        if (!k.supported) {
+            std::cout << std::setw(8) << k.name << "  skipped, not supported by this CPU\n";
+            continue;
+        }
+        std::mt19937_64 rng(seed);
+        uint64_t levels = 0;
+        for (int c = 0; c < cases; c++) {
+            int size = static_cast<int>(rng() % (kMaxCheckLevels + 1));
+            int64_t max_lots = buildSide(qty, price, size, rng);
+            int ref = depthKernelScalar(qty.data(), price.data(), size, max_lots, ref_qty, ref_cost);
+            int got = k.kernel(qty.data(), price.data(), size, max_lots, got_qty, got_cost);
+            levels += ref;
+
+            bool match = ref == got && std::equal(ref_qty, ref_qty + ref, got_qty) &&
+                         std::equal(ref_cost, ref_cost + ref, got_cost);
+            if (!match) {
+                std::cout << std::setw(8) << k.name << "  MISMATCH on case " << c << ": size " << size
+                          << ", max_lots " << max_lots << ", levels " << got << " (scalar " << ref << ")\n";
+                for (int i = 0; i < std::max(ref, got); i++)
+                    std::cout << "  " << i << ": qty " << qty[i] << " price " << price[i]
+                              << " -> " << got_qty[i] << "/" << got_cost[i]
+                              << " (scalar " << ref_qty[i] << "/" << ref_cost[i] << ")\n";
+                return 1;
+            }
+        }
+        std::cout << std::setw(8) << k.name << "  " << cases << " sides, " << levels
+                  << " levels identical to scalar\n";
+    }
+    return 0;
+}
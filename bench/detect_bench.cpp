@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "orderbook.hpp"
+#include "utils.hpp"
+#include "work_pool.hpp"
+
+/// @brief Default number of timed detections per configuration
+const int kDefaultIterations = 200;
+
+/// @brief Book counts swept when none is given on the command line
+const int kDefaultBookCounts[] = {4, 8, 16, 32};
+
+/**
+ * @brief Builds a synthetic full-depth book around a mid price
+ *
+ * Levels are one tick apart with random quantities, and the order size
+ * limit is high enough that computeDepth() keeps every level, so each
+ * exchange pair costs a full O(levels) merge when its books cross.
+ */
+void buildBook(L2OrderBook& ob, double mid, std::mt19937_64& rng) {
+    ob = {};
+    ob.scale = kDefaultScale;
+    std::uniform_real_distribution<double> qty(0.05, 2.0);
+    Ticks mid_ticks = toFixed(mid, ob.scale.price_decimals);
+    for (int i = 0; i < kMaxSize; i++) {
+        ob.askPrice[i] = mid_ticks + 1 + i;
+        ob.bidPrice[i] = mid_ticks - 1 - i;
+        ob.askQuantity[i] = toFixed(qty(rng), ob.scale.qty_decimals);
+        ob.bidQuantity[i] = toFixed(qty(rng), ob.scale.qty_decimals);
+    }
+    ob.askSize = ob.bidSize = kMaxSize;
+    computeDepth(ob, toFixed(1000.0, ob.scale.qty_decimals));
+}
+
+/// @brief Order-sensitive digest of a detection's output, to compare runs
+uint64_t digest(const std::vector<Opportunity>& opps) {
+    uint64_t h = opps.size();
+    for (const auto& opp : opps)
+        h = h * 1000003 + static_cast<uint64_t>(opp.buy_exchange * 131 + opp.sell_exchange) +
+            static_cast<uint64_t>(opp.net_profit * 1e6);
+    return h;
+}
+
+/**
+ * @brief Times detectPairs() over every ordered pair of books, once per helper count
+ *
+ * Mids are spread over $40 against a $12 round-trip fee, so a large share
+ * of the pairs cross through every level and run the full merge;
+ * min_profit is 0 so nothing is pruned from top of book. The serial run is the baseline of the speedup column, and
+ * every parallel run is checked to produce the same opportunities.
+ */
+bool benchBooks(int books, const std::vector<int>& helper_counts, int iterations) {
+    std::mt19937_64 rng(books);
+    std::uniform_real_distribution<double> mid(59980.0, 60020.0);
+    std::vector<L2OrderBook> local_books(books);
+    for (int b = 0; b < books; b++)
+        buildBook(local_books[b], mid(rng), rng);
+
+    std::vector<ExchangePair> pairs;
+    int64_t fee = feeUnits(0.02);
+    for (int i = 0; i < books; i++)
+        for (int j = 0; j < books; j++)
+            if (i != j)
+                pairs.push_back({i, j, fee});
+    const int count = static_cast<int>(pairs.size());
+
+    double serial_ns = 0.0;
+    uint64_t expected = 0;
+    for (int helpers : helper_counts) {
+        WorkStealingPool pool(helpers);
+        std::vector<DetectLane> lanes(pool.size());
+        std::vector<Opportunity> out;
+        auto received = std::chrono::high_resolution_clock::now();
+
+        // Warm-up, also wakes every helper once
+        detectPairs(local_books.data(), pairs.data(), count, 0.0, received, &pool, 1, lanes, out);
+        uint64_t got = digest(out);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++)
+            detectPairs(local_books.data(), pairs.data(), count, 0.0, received, &pool, 1, lanes, out);
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+
+        if (helpers == helper_counts.front()) {
+            serial_ns = ns;
+            expected = got;
+        }
+        bool match = got == expected;
+
+        std::cout << std::setw(6) << books << std::setw(7) << count << std::setw(7) << out.size()
+                  << std::setw(9) << pool.size() << std::setw(13) << std::fixed << std::setprecision(0) << ns
+                  << std::setw(11) << std::setprecision(1) << ns / count
+                  << std::setw(9) << std::setprecision(2) << serial_ns / ns
+                  << std::setw(9) << std::setprecision(2) << serial_ns / ns / pool.size()
+                  << (match ? "" : "   MISMATCH") << "\n";
+        if (!match)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Scaling benchmark of parallel detection on synthetic books
+ *
+ * Usage: arb_detect_bench [--iterations N] [--threads T] [books ...]
+ *
+ * For each book count, times one detection over all books * (books - 1)
+ * exchange pairs with 1, 2, 4, ... participants up to T (defaults to the
+ * number of hardware threads), and reports ns per detection, ns per pair,
+ * speedup over the serial run and parallel efficiency.
+ */
+int main(int argc, char** argv) {
+    int iterations = kDefaultIterations;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> book_counts;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+            continue;
+        }
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = std::clamp(std::atoi(argv[++i]), 1, kMaxDetectThreads + 1);
+            continue;
+        }
+        int books = std::atoi(argv[i]);
+        if (books < 2) {
+            std::cerr << "usage: " << argv[0] << " [--iterations N] [--threads T] [books ...]\n";
+            return 1;
+        }
+        book_counts.push_back(books);
+    }
+    if (book_counts.empty())
+        book_counts.assign(std::begin(kDefaultBookCounts), std::end(kDefaultBookCounts));
+
+    std::vector<int> helper_counts;
+    for (int participants = 1; participants < threads; participants *= 2)
+        helper_counts.push_back(participants - 1);
+    helper_counts.push_back(threads - 1);
+
+#ifndef __OPTIMIZE__
+    std::cerr << "warning: built without optimization, configure with -DCMAKE_BUILD_TYPE=Release\n";
+#endif
+    if (std::thread::hardware_concurrency() < static_cast<unsigned>(threads))
+        std::cerr << "warning: " << threads << " threads on " << std::thread::hardware_concurrency()
+                  << " hardware threads, speedups will not be meaningful\n";
+
+    std::cout << std::setw(6) << "books" << std::setw(7) << "pairs" << std::setw(7) << "opps"
+              << std::setw(9) << "threads" << std::setw(13) << "ns/detect" << std::setw(11) << "ns/pair"
+              << std::setw(9) << "speedup" << std::setw(9) << "eff" << "\n";
+    for (int books : book_counts)
+        if (!benchBooks(books, helper_counts, iterations))
+            return 1;
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include <simdjson.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "book_parser.hpp"
+#include "orderbook.hpp"
+#include "utils.hpp"
+
+#ifndef ARB_BENCH_DATA_DIR
+#define ARB_BENCH_DATA_DIR "bench/data"
+#endif
+
+/// @brief Default number of passes over each corpus in the throughput run
+const int kDefaultIterations = 2000;
+
+/**
+ * @brief Captured L2 messages of one venue
+ *
+ * One JSON message per line, as written by wsClient when "capture_dir" is
+ * set in config.json.
+ */
+struct Corpus {
+    int exchange;                                  ///< Index of the venue in kExchanges
+    std::string path;                              ///< File the messages were read from
+    std::vector<simdjson::padded_string> messages; ///< Payloads, padded as simdjson requires
+    size_t bytes = 0;                              ///< Total payload size
+};
+
+/**
+ * @brief Loads a corpus file, one message per non-empty line
+ * @return false if the file cannot be opened or holds no messages
+ */
+bool loadCorpus(Corpus& corpus) {
+    std::ifstream in(corpus.path);
+    if (!in)
+        return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty())
+            continue;
+        corpus.bytes += line.size();
+        corpus.messages.emplace_back(line);
+    }
+    return !corpus.messages.empty();
+}
+
+/**
+ * @brief Times the production parser of a venue over its corpus
+ *
+ * Uses the same path as wsClient::onMessage: iterate the padded payload
+ * and run the venue's parseBook instantiation into an L2OrderBook.
+ *
+ * - Throughput: iterations back-to-back passes timed as a whole
+ * - Distribution: one more pass timing every message on its own (includes
+ *   the clock read overhead, ~20ns)
+ */
+void benchCorpus(const Corpus& corpus, int iterations) {
+    simdjson::ondemand::parser parser;
+    L2OrderBook ob{};
+    ob.scale = kDefaultScale;
+    BookParser parse = bookParserFor(corpus.exchange);
+
+    uint64_t checksum = 0;
+    uint64_t levels = 0;
+    for (const auto& msg : corpus.messages) {
+        simdjson::ondemand::document doc = parser.iterate(msg);
+        parse(doc, ob);
+        levels += ob.askSize + ob.bidSize;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        for (const auto& msg : corpus.messages) {
+            simdjson::ondemand::document doc = parser.iterate(msg);
+            parse(doc, ob);
+            checksum += static_cast<uint64_t>(ob.askPrice[0] + ob.bidQuantity[0]);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    std::vector<int64_t> samples;
+    samples.reserve(corpus.messages.size());
+    for (const auto& msg : corpus.messages) {
+        auto t0 = std::chrono::steady_clock::now();
+        simdjson::ondemand::document doc = parser.iterate(msg);
+        parse(doc, ob);
+        auto t1 = std::chrono::steady_clock::now();
+        checksum += static_cast<uint64_t>(ob.bidPrice[0]);
+        samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    }
+    std::sort(samples.begin(), samples.end());
+
+    double total_ns = std::chrono::duration<double, std::nano>(end - start).count();
+    double messages = static_cast<double>(corpus.messages.size()) * iterations;
+    double ns_per_msg = total_ns / messages;
+    double mb_per_s = static_cast<double>(corpus.bytes) * iterations / total_ns * 1e3;
+
+    std::cout << std::left << std::setw(9) << kExchanges[corpus.exchange] << std::right
+              << std::setw(7) << corpus.messages.size()
+              << std::setw(9) << std::fixed << std::setprecision(1)
+              << static_cast<double>(levels) / corpus.messages.size()
+              << std::setw(11) << ns_per_msg
+              << std::setw(13) << std::setprecision(0) << 1e9 / ns_per_msg
+              << std::setw(9) << std::setprecision(1) << mb_per_s
+              << std::setw(9) << samples[samples.size() / 2]
+              << std::setw(9) << samples[samples.size() * 99 / 100]
+              << "   (checksum " << (checksum & 0xFFFF) << ")\n";
+}
+
+/**
+ * @brief Parser microbenchmark over captured exchange payloads
+ *
+ * Usage: arb_parse_bench [--iterations N] [venue=path ...]
+ *
+ * Without venue arguments the corpora shipped in bench/data are used
+ * (okx.jsonl, deribit.jsonl, bybit.jsonl). Reports ns/message,
+ * messages/sec, MB/s and the p50/p99 of single-message parse times.
+ */
+int main(int argc, char** argv) {
+    int iterations = kDefaultIterations;
+    std::vector<Corpus> corpora;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+            continue;
+        }
+        auto eq = arg.find('=');
+        int exchange = eq == std::string_view::npos ? -1 : getIndex(arg.substr(0, eq), 1);
+        if (exchange == -1) {
+            std::cerr << "usage: " << argv[0] << " [--iterations N] [venue=path ...]\n"
+                      << "venues: okx, deribit, bybit\n";
+            return 1;
+        }
+        corpora.push_back({exchange, std::string(arg.substr(eq + 1)), {}});
+    }
+    if (corpora.empty()) {
+        for (int i = 0; i < kTotalExchanges; i++) {
+            std::ostringstream path;
+            path << ARB_BENCH_DATA_DIR << "/" << kExchanges[i] << ".jsonl";
+            corpora.push_back({i, path.str(), {}});
+        }
+    }
+
+#ifndef __OPTIMIZE__
+    std::cerr << "warning: built without optimization, configure with -DCMAKE_BUILD_TYPE=Release\n";
+#endif
+
+    std::cout << "simdjson kernel: " << simdjson::builtin_implementation()->name() << "\n";
+    std::cout << std::left << std::setw(9) << "venue" << std::right
+              << std::setw(7) << "msgs" << std::setw(9) << "lvl/msg"
+              << std::setw(11) << "ns/msg" << std::setw(13) << "msgs/sec"
+              << std::setw(9) << "MB/s" << std::setw(9) << "p50 ns" << std::setw(9) << "p99 ns" << "\n";
+
+    try {
+        for (auto& corpus : corpora) {
+            if (!loadCorpus(corpus)) {
+                std::cerr << "no messages in " << corpus.path << "\n";
+                return 1;
+            }
+            benchCorpus(corpus, iterations);
+        }
+    } catch (const simdjson::simdjson_error& e) {
+        std::cerr << "parse error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,219 @@
+#include <simdjson.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "book_parser.hpp"
+#include "orderbook.hpp"
+#include "recorder.hpp"
+#include "utils.hpp"
+
+#ifndef ARB_BENCH_DATA_DIR
+#define ARB_BENCH_DATA_DIR "bench/data"
+#endif
+
+/// @brief Default number of passes over the books in the timed encode and decode runs
+const int kDefaultIterations = 200;
+
+/**
+ * @brief Books parsed from the captured L2 messages of one venue
+ *
+ * One JSON message per line, as written by wsClient when "capture_dir" is
+ * set in config.json.
+ */
+struct Corpus {
+    int exchange;                     ///< Index of the venue in kExchanges
+    std::string path;                 ///< File the messages were read from
+    std::vector<RecordedBook> books;  ///< Parsed books, in file order
+    size_t bytes = 0;                 ///< Total payload size
+};
+
+/**
+ * @brief Loads and parses a corpus file, one message per non-empty line
+ *
+ * Books are stamped 10 ms apart with a 20 us receive delay, a little
+ * faster than the venues publish, so time deltas cost what they would live.
+ *
+ * @return false if the file cannot be opened or holds no messages
+ */
+bool loadCorpus(Corpus& corpus) {
+    std::ifstream in(corpus.path);
+    if (!in)
+        return false;
+    simdjson::ondemand::parser parser;
+    BookParser parse = bookParserFor(corpus.exchange);
+    L2OrderBook ob{};
+    ob.scale = kDefaultScale;
+    auto t = std::chrono::high_resolution_clock::now();
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty())
+            continue;
+        corpus.bytes += line.size() + 1;
+        simdjson::padded_string payload(line);
+        simdjson::ondemand::document doc = parser.iterate(payload);
+        parse(doc, ob);
+        t += std::chrono::milliseconds(10);
+        ob.t = t;
+        ob.rxTime = t - std::chrono::microseconds(20);
+        corpus.books.push_back(toRecordedBook(corpus.exchange, 0, ob));
+    }
+    return !corpus.books.empty();
+}
+
+/// @brief Whether two books hold the same levels and timestamps
+bool sameBook(const RecordedBook& a, const RecordedBook& b) {
+    return a.t_ns == b.t_ns && a.rx_ns == b.rx_ns && a.exchange == b.exchange && a.pair == b.pair &&
+           a.price_decimals == b.price_decimals && a.qty_decimals == b.qty_decimals &&
+           a.askSize == b.askSize && a.bidSize == b.bidSize &&
+           std::equal(a.askPrice, a.askPrice + a.askSize, b.askPrice) &&
+           std::equal(a.askQuantity, a.askQuantity + a.askSize, b.askQuantity) &&
+           std::equal(a.bidPrice, a.bidPrice + a.bidSize, b.bidPrice) &&
+           std::equal(a.bidQuantity, a.bidQuantity + a.bidSize, b.bidQuantity);
+}
+
+/**
+ * @brief Records a corpus, reads it back and times both directions
+ *
+ * The size column is one recording of the corpus against its raw JSON;
+ * the timed runs write iterations copies of it to one file and read that
+ * file back, so chunks are full and the disk cache is warm.
+ *
+ * @return false if a decoded book differs from the one recorded
+ */
+bool benchCorpus(const Corpus& corpus, const std::string& path, int iterations) {
+    RecordingWriter writer;
+    writer.open(path);
+    for (const auto& book : corpus.books)
+        writer.append(book);
+    writer.flush();
+    uint64_t recorded_bytes = writer.bytesWritten();
+
+    RecordingReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "cannot read back " << path << "\n";
+        return false;
+    }
+    RecordedBook book;
+    size_t n = 0;
+    while (reader.next(book)) {
+        if (n >= corpus.books.size() || !sameBook(book, corpus.books[n])) {
+            std::cerr << kExchanges[corpus.exchange] << ": book " << n << " does not round-trip\n";
+            return false;
+        }
+        n++;
+    }
+    if (n != corpus.books.size()) {
+        std::cerr << kExchanges[corpus.exchange] << ": read " << n << " of " << corpus.books.size() << " books\n";
+        return false;
+    }
+
+    RecordingWriter timed;
+    timed.open(path);
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++)
+        for (const auto& b : corpus.books)
+            timed.append(b);
+    timed.flush();
+    auto mid = std::chrono::steady_clock::now();
+
+    RecordingReader timed_reader;
+    timed_reader.open(path);
+    uint64_t checksum = 0;
+    while (timed_reader.next(book))
+        checksum += static_cast<uint64_t>(book.askPrice[0] + book.bidQuantity[0]);
+    auto end = std::chrono::steady_clock::now();
+
+    double books = static_cast<double>(corpus.books.size()) * iterations;
+    double encode_ns = std::chrono::duration<double, std::nano>(mid - start).count() / books;
+    double decode_ns = std::chrono::duration<double, std::nano>(end - mid).count() / books;
+
+    std::cout << std::left << std::setw(9) << kExchanges[corpus.exchange] << std::right
+              << std::setw(7) << corpus.books.size()
+              << std::setw(11) << corpus.bytes
+              << std::setw(11) << recorded_bytes
+              << std::setw(9) << std::fixed << std::setprecision(1)
+              << 100.0 * static_cast<double>(recorded_bytes) / static_cast<double>(corpus.bytes)
+              << std::setw(11) << encode_ns
+              << std::setw(11) << decode_ns
+              << "   (checksum " << (checksum & 0xFFFF) << ")\n";
+    return true;
+}
+
+/**
+ * @brief Size and speed of the book recording format on captured payloads
+ *
+ * Usage: arb_record_bench [--iterations N] [venue=path ...]
+ *
+ * Without venue arguments the corpora shipped in bench/data are used.
+ * Each corpus is parsed as wsClient does, recorded, read back and
+ * compared book by book; reports raw JSON bytes, recorded bytes, the
+ * recording's size in percent of the JSON, and ns per book to encode and
+ * to decode.
+ */
+int main(int argc, char** argv) {
+    int iterations = kDefaultIterations;
+    std::vector<Corpus> corpora;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+            continue;
+        }
+        auto eq = arg.find('=');
+        int exchange = eq == std::string_view::npos ? -1 : getIndex(arg.substr(0, eq), 1);
+        if (exchange == -1) {
+            std::cerr << "usage: " << argv[0] << " [--iterations N] [venue=path ...]\n"
+                      << "venues: okx, deribit, bybit\n";
+            return 1;
+        }
+        corpora.push_back({exchange, std::string(arg.substr(eq + 1)), {}});
+    }
+    if (corpora.empty()) {
+        for (int i = 0; i < kTotalExchanges; i++) {
+            std::ostringstream path;
+            path << ARB_BENCH_DATA_DIR << "/" << kExchanges[i] << ".jsonl";
+            corpora.push_back({i, path.str(), {}});
+        }
+    }
+
+#ifndef __OPTIMIZE__
+    std::cerr << "warning: built without optimization, configure with -DCMAKE_BUILD_TYPE=Release\n";
+#endif
+
+    const std::string path = "arb_record_bench.l2rec";
+    std::cout << std::left << std::setw(9) << "venue" << std::right
+              << std::setw(7) << "books" << std::setw(11) << "json B" << std::setw(11) << "rec B"
+              << std::setw(9) << "rec %" << std::setw(11) << "enc ns" << std::setw(11) << "dec ns" << "\n";
+
+    bool ok = true;
+    try {
+        for (auto& corpus : corpora) {
+            if (!loadCorpus(corpus)) {
+                std::cerr << "no messages in " << corpus.path << "\n";
+                ok = false;
+                break;
+            }
+            if (!benchCorpus(corpus, path, iterations)) {
+                ok = false;
+                break;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        ok = false;
+    }
+    std::remove(path.c_str());
+    return ok ? 0 : 1;
+}
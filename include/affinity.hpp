@@ -0,0 +1,35 @@
+#pragma once
+
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Spin-wait hint for busy-poll loops
+ *
+ * Tells the core it is in a spin loop (PAUSE on x86, YIELD on ARM), which
+ * saves power and frees pipeline resources for a sibling hyperthread.
+ */
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+/**
+ * @brief Pins a thread to one core and optionally makes it real-time
+ *
+ * Failures (core out of range, missing CAP_SYS_NICE for SCHED_FIFO) are
+ * reported on stderr and leave the thread running with its old policy.
+ *
+ * @param thread Native handle of the thread
+ * @param core Core to pin to, or -1 to leave affinity unchanged
+ * @param rt_priority SCHED_FIFO priority (1-99), or 0 to keep the default scheduler
+ * @param name Thread name used in messages
+ * @return true if every requested setting was applied
+ */
+bool applyThreadPolicy(pthread_t thread, int core, int rt_priority, const char* name);
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "orderbook.hpp"
+#include "replay.hpp"
+#include "utils.hpp"
+
+/// @brief One book of a BookTape; its levels live in the tape's level arrays
+struct TapeBook {
+    std::chrono::high_resolution_clock::time_point t;       ///< Start of message handling
+    std::chrono::high_resolution_clock::time_point rxTime;  ///< Socket receive time
+    uint64_t levels;       ///< Index of the first ask level; the bids follow the asks
+    uint16_t askSize;      ///< Ask levels
+    uint16_t bidSize;      ///< Bid levels
+    int exchange;          ///< Index of the exchange in kExchanges
+    Scale scale;           ///< Fixed-point scale of the levels
+};
+
+/**
+ * @brief Book history held in memory for backtesting
+ *
+ * Only raw levels are kept, packed back to back, so a tape costs about 16
+ * bytes per level instead of a full L2OrderBook per update. The books of
+ * each pair stay in feed order.
+ */
+struct BookTape {
+    std::vector<TapeBook> books[kTotalPairs];  ///< Books of each pair, in feed order
+    std::vector<Ticks> prices;                 ///< Level prices of every book
+    std::vector<Lots> quantities;              ///< Level quantities matching prices
+    uint64_t skipped = 0;                      ///< Books of disabled or unknown exchanges and pairs, or unreadable payloads
+
+    /// @brief Books on the tape
+    size_t size() const;
+
+    /**
+     * @brief Copies a book's levels, scale and timestamps into ob
+     *
+     * The depth fields are left untouched; call computeDepth() before
+     * detecting on the book.
+     */
+    void restore(const TapeBook& book, L2OrderBook& ob) const;
+};
+
+/**
+ * @brief Reads a whole feed into a tape
+ * @param feed Opened source of books
+ * @param cfg Configuration; books of disabled exchanges and pairs are skipped
+ * @param tape Receives the books
+ */
+void loadTape(ReplayFeed& feed, const config& cfg, BookTape& tape);
+
+/// @brief Settings one backtest run overrides in the configuration
+struct BacktestVariant {
+    double min_profit;                 ///< Minimum net profit (quote currency) per opportunity
+    double max_order_size;             ///< Order size limit (base currency)
+    double fees[kTotalExchanges];      ///< Fee of each exchange, in percent
+};
+
+/// @brief Outcome of one variant on one pair
+struct BacktestResult {
+    uint64_t updates = 0;              ///< Books detected on
+    uint64_t opportunities = 0;        ///< Opportunities reported
+    double notional = 0.0;             ///< Sum of order_size * buy_vwap, in quote currency
+    double profit = 0.0;               ///< Sum of net_profit, in quote currency
+    uint64_t pairs_pruned = 0;         ///< Exchange pairs rejected by the top-of-book filter
+    uint64_t stale_skipped = 0;        ///< Exchange pairs skipped for a stale book
+    uint64_t overflows = 0;            ///< Books whose notional overflowed at this order size
+};
+
+/**
+ * @brief Runs every variant over a tape, in parallel
+ *
+ * Each (variant, pair) is one task: its books are replayed in order
+ * through computeDepth(), selectPairs() and detectPairs(), the steps
+ * ingestBook() and process() take live, with the variant's settings. Books
+ * are aged at the handler time of the update being detected, where replay
+ * adds the real detection time on top.
+ *
+ * @param tape Books to replay
+ * @param cfg Base configuration; exchanges, pairs, incremental and book
+ *            age limits are read, the variants supply the rest
+ * @param variants Settings of each run
+ * @param threads Threads running tasks, the caller included
+ * @return Results of each variant, indexed by pair
+ */
+std::vector<std::array<BacktestResult, kTotalPairs>> runBacktest(
+    const BookTape& tape, const config& cfg, const std::vector<BacktestVariant>& variants, int threads);
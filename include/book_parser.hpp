@@ -0,0 +1,158 @@
+#pragma once
+
+#include <simdjson.h>
+#ifdef VALIDATE_PARSER
+#include <iostream>
+#endif
+#include "decimal_parser.hpp"
+#include "orderbook.hpp"
+#include "utils.hpp"
+
+/// @brief How an exchange encodes numbers inside its level arrays
+enum class NumberEncoding {
+    kQuoted,  ///< Numbers sent as JSON strings, e.g. ["95000.5", "1.2"]
+    kBare     ///< Numbers sent as JSON numbers, e.g. [95000.5, 1.2]
+};
+
+/**
+ * @brief Compile-time description of an exchange's L2 message layout
+ *
+ * Every branch on the layout is resolved when parseBook is instantiated,
+ * so the per-value loop contains no runtime format checks.
+ *
+ * @tparam Encoding Number encoding inside each [price, quantity] level
+ * @tparam PriceIndex Position of the price within a level array
+ * @tparam QtyIndex Position of the quantity within a level array
+ */
+template <NumberEncoding Encoding, int PriceIndex, int QtyIndex>
+struct BookSchema {
+    static constexpr NumberEncoding kEncoding = Encoding;
+    static constexpr int kPriceIndex = PriceIndex;
+    static constexpr int kQtyIndex = QtyIndex;
+};
+
+/// @brief OKX: quoted numbers, [price, quantity, ...]
+using OkxSchema = BookSchema<NumberEncoding::kQuoted, 0, 1>;
+
+/// @brief Deribit: bare numbers, [price, quantity]
+using DeribitSchema = BookSchema<NumberEncoding::kBare, 0, 1>;
+
+/// @brief Bybit: quoted numbers, [price, quantity]
+using BybitSchema = BookSchema<NumberEncoding::kQuoted, 0, 1>;
+
+/**
+ * @brief Parses one number of a level through simdjson's double parser
+ * @param val Level element holding the number
+ * @param decimals Decimal places of the fixed-point result
+ * @return Fixed-point value
+ */
+template <typename Schema>
+inline int64_t parseLevelDouble(simdjson::ondemand::value val, int decimals) {
+    if constexpr (Schema::kEncoding == NumberEncoding::kQuoted) {
+        return toFixed(val.get_double_in_string(), decimals);
+    } else {
+        return toFixed(val.get_double(), decimals);
+    }
+}
+
+/**
+ * @brief Parses one number of a level in the schema's encoding
+ *
+ * The raw token is converted straight to fixed point by parseDecimal(),
+ * which handles quoted and bare numbers alike; exponents and over-long
+ * numbers fall back to simdjson. With VALIDATE_PARSER every value is also
+ * parsed by simdjson and differences beyond one unit of rounding are logged.
+ *
+ * @param val Level element holding the number
+ * @param decimals Decimal places of the fixed-point result
+ * @return Fixed-point value
+ */
+template <typename Schema>
+inline int64_t parseLevelValue(simdjson::ondemand::value val, int decimals) {
+    std::string_view token = val.raw_json_token();
+    int64_t fixed;
+    if (!parseDecimal(token, decimals, fixed))
+        return parseLevelDouble<Schema>(val, decimals);
+#ifdef VALIDATE_PARSER
+    int64_t reference = parseLevelDouble<Schema>(val, decimals);
+    if (fixed - reference > 1 || reference - fixed > 1)
+        std::cerr << "Decimal parser mismatch on " << token << ": " << fixed
+                  << " vs simdjson " << reference << std::endl;
+#endif
+    return fixed;
+}
+
+/**
+ * @brief Parses one side ("asks" or "bids") of a message into the book arrays
+ * @param levels Array of levels
+ * @param price Output prices in ticks
+ * @param qty Output quantities in lots
+ * @param scale Fixed-point scale of the book
+ * @return Number of levels parsed, at most kMaxSize
+ */
+template <typename Schema>
+inline int parseSide(simdjson::ondemand::array levels, Ticks* price, Lots* qty, Scale scale) {
+    int i = 0;
+    for (auto level : levels) {
+        if (i == kMaxSize)
+            break;
+        int j = 0;
+        for (auto val : level) {
+            if (j == Schema::kPriceIndex) {
+                price[i] = parseLevelValue<Schema>(val.value(), scale.price_decimals);
+            } else if (j == Schema::kQtyIndex) {
+                qty[i] = parseLevelValue<Schema>(val.value(), scale.qty_decimals);
+            }
+            j++;
+        }
+        i++;
+    }
+    return i;
+}
+
+/**
+ * @brief Parses an L2 message of one exchange schema into an orderbook
+ *
+ * Fills prices, quantities and sizes of both sides in the book's own scale.
+ * A side missing from the message is left empty.
+ *
+ * @tparam Schema Exchange schema (OkxSchema, DeribitSchema, BybitSchema)
+ * @param doc Document iterated over the message payload
+ * @param ob Book to fill; its scale must already be set
+ */
+template <typename Schema>
+void parseBook(simdjson::ondemand::document& doc, L2OrderBook& ob) {
+    simdjson::ondemand::array asks;
+    ob.askSize = doc["asks"].get(asks) == simdjson::SUCCESS
+                     ? parseSide<Schema>(asks, ob.askPrice, ob.askQuantity, ob.scale)
+                     : 0;
+#ifdef FAKE
+    for (int i = 0; i < ob.askSize; i++)
+        ob.askPrice[i] -= 1000 * kPow10[ob.scale.price_decimals];
+#endif
+
+    simdjson::ondemand::array bids;
+    ob.bidSize = doc["bids"].get(bids) == simdjson::SUCCESS
+                     ? parseSide<Schema>(bids, ob.bidPrice, ob.bidQuantity, ob.scale)
+                     : 0;
+}
+
+/// @brief Parser instantiated for one exchange schema
+using BookParser = void (*)(simdjson::ondemand::document& doc, L2OrderBook& ob);
+
+/**
+ * @brief Selects the parser instantiation for an exchange
+ * @param exchange Index of the exchange in kExchanges
+ * @return Parser specialized for that exchange's schema
+ * @note Order must match kExchanges array
+ */
+inline BookParser bookParserFor(int exchange) {
+    switch (exchange) {
+        case 0:
+            return parseBook<OkxSchema>;
+        case 1:
+            return parseBook<DeribitSchema>;
+        default:
+            return parseBook<BybitSchema>;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Clock the detectors timestamp opportunities and age books with
+ *
+ * Live, this is the system clock. During replay it is a virtual clock
+ * anchored on the recorded time of the book being replayed: now() returns
+ * that time plus the real time elapsed since the book was injected. Book
+ * ages and detection latencies then come out as they would have live,
+ * whatever the replay speed.
+ *
+ * The anchor is one atomic offset, so readers never see a torn update.
+ */
+class DetectionClock {
+public:
+    /// @brief Current time of the detectors
+    static std::chrono::high_resolution_clock::time_point now() {
+        if (!virtual_.load(std::memory_order_relaxed))
+            return std::chrono::high_resolution_clock::now();
+        int64_t ns = steadyNs() + offset_ns_.load(std::memory_order_acquire);
+        return std::chrono::high_resolution_clock::time_point(
+            std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::nanoseconds(ns)));
+    }
+
+    /**
+     * @brief Switches to virtual time, with now() equal to recorded at this instant
+     * @param recorded Recorded time of the book about to be injected
+     */
+    static void anchor(std::chrono::high_resolution_clock::time_point recorded) {
+        int64_t recorded_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(recorded.time_since_epoch()).count();
+        offset_ns_.store(recorded_ns - steadyNs(), std::memory_order_release);
+        virtual_.store(true, std::memory_order_release);
+    }
+
+    /// @brief Whether now() is virtual
+    static bool isVirtual() { return virtual_.load(std::memory_order_relaxed); }
+
+private:
+    static int64_t steadyNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static inline std::atomic<bool> virtual_{false};     ///< Set by the first anchor()
+    static inline std::atomic<int64_t> offset_ns_{0};    ///< Virtual minus steady time, in nanoseconds
+};
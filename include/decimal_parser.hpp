@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "utils.hpp"
+
+/// @brief Maximum significant digits accepted before falling back to simdjson
+const int kMaxDecimalDigits = 18;
+
+/**
+ * @brief Checks whether 8 bytes are all ASCII digits (SWAR)
+ * @param chunk 8 bytes loaded little-endian
+ */
+inline bool isEightDigits(uint64_t chunk) {
+    return ((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+            (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+           0x3333333333333333ULL;
+}
+
+/**
+ * @brief Converts 8 ASCII digits to their value in three multiplies (SWAR)
+ * @param chunk 8 digit bytes loaded little-endian, most significant first in memory
+ */
+inline uint32_t parseEightDigits(uint64_t chunk) {
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 0x000F424000000064ULL;  // 100 + (1000000 << 32)
+    const uint64_t mul2 = 0x0000271000000001ULL;  // 1 + (10000 << 32)
+    chunk -= 0x3030303030303030ULL;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32;
+    return static_cast<uint32_t>(chunk);
+}
+
+/**
+ * @brief Parses a decimal JSON token straight into a fixed-point integer
+ *
+ * Accepts an optional surrounding pair of quotes, an optional minus sign,
+ * integer digits and an optional fraction. The result is the value times
+ * 10^decimals, rounded half away from zero on the first dropped digit.
+ * Trailing whitespace (as left by simdjson's raw tokens) is ignored.
+ *
+ * Runs of 8 digits are converted with SWAR; the rest one digit at a time.
+ *
+ * @param token Raw token, e.g. "\"95000.25\"" or "95000.25"
+ * @param decimals Decimal places kept
+ * @param out Fixed-point result
+ * @return false for exponents, malformed input or more than
+ *         kMaxDecimalDigits significant digits; the caller should fall back
+ *         to a full floating-point parse
+ */
+inline bool parseDecimal(std::string_view token, int decimals, int64_t& out) {
+    const char* p = token.data();
+    const char* end = p + token.size();
+    if (p < end && *p == '"')
+        ++p;
+    bool negative = p < end && *p == '-';
+    p += negative;
+
+    const char* start = p;
+    uint64_t value = 0;
+    int digits = 0;
+    uint64_t chunk;
+    while (end - p >= 8) {
+        std::memcpy(&chunk, p, 8);
+        if (!isEightDigits(chunk))
+            break;
+        value = value * 100000000ULL + parseEightDigits(chunk);
+        digits += 8;
+        p += 8;
+    }
+    while (p < end && static_cast<unsigned>(*p - '0') < 10) {
+        value = value * 10 + static_cast<unsigned>(*p - '0');
+        ++digits;
+        ++p;
+    }
+    if (p == start)
+        return false;
+
+    int frac = 0;
+    bool round_up = false;
+    if (p < end && *p == '.') {
+        ++p;
+        while (frac + 8 <= decimals && end - p >= 8) {
+            std::memcpy(&chunk, p, 8);
+            if (!isEightDigits(chunk))
+                break;
+            value = value * 100000000ULL + parseEightDigits(chunk);
+            frac += 8;
+            p += 8;
+        }
+        while (frac < decimals && p < end && static_cast<unsigned>(*p - '0') < 10) {
+            value = value * 10 + static_cast<unsigned>(*p - '0');
+            ++frac;
+            ++p;
+        }
+        round_up = p < end && *p >= '5' && *p <= '9';
+        while (p < end && static_cast<unsigned>(*p - '0') < 10)
+            ++p;
+    }
+    if (digits + decimals > kMaxDecimalDigits)
+        return false;
+
+    if (p < end && *p == '"')
+        ++p;
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        ++p;
+    if (p != end)
+        return false;
+
+    int64_t fixed = static_cast<int64_t>(value * kPow10[decimals - frac] + round_up);
+    out = negative ? -fixed : fixed;
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Signature of a kernel building one side's cumulative arrays
+ *
+ * Computes running quantity (lots) and notional (ticks * lots) over the
+ * first levels of one book side, stopping at the level that fills
+ * max_lots; that level is only partially taken so the last cumulative
+ * quantity equals the limit.
+ *
+ * @param qty Level quantities in lots (SoA, best level first)
+ * @param price Level prices in ticks (SoA, best level first)
+ * @param size Number of valid levels
+ * @param max_lots Maximum order size in lots
+ * @param cum_qty Output cumulative quantities
+ * @param cum_cost Output cumulative notionals
+ * @return Number of levels used (valid entries written to the outputs)
+ */
+using DepthKernel = int (*)(const int64_t* qty, const int64_t* price, int size,
+                            int64_t max_lots, int64_t* cum_qty, int64_t* cum_cost);
+
+/// @brief Portable reference kernel, one level at a time
+int depthKernelScalar(const int64_t* qty, const int64_t* price, int size,
+                      int64_t max_lots, int64_t* cum_qty, int64_t* cum_cost);
+
+/// @brief AVX2 kernel, 4 levels per step (x86-64 only)
+int depthKernelAvx2(const int64_t* qty, const int64_t* price, int size,
+                    int64_t max_lots, int64_t* cum_qty, int64_t* cum_cost);
+
+/// @brief AVX-512F/DQ kernel, 8 levels per step (x86-64 only)
+int depthKernelAvx512(const int64_t* qty, const int64_t* price, int size,
+                      int64_t max_lots, int64_t* cum_qty, int64_t* cum_cost);
+
+/**
+ * @brief Picks the widest kernel the running CPU supports
+ * @return AVX-512, AVX2 or scalar kernel, in that order of preference
+ */
+DepthKernel selectDepthKernel();
+
+/**
+ * @brief Name of the kernel selectDepthKernel() would pick
+ * @return "avx512", "avx2" or "scalar"
+ */
+const char* depthKernelName();
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include <pthread.h>
+#include <thread>
+#include <vector>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_service.hpp>
+
+/// @brief Event loop type shared by websocket endpoints
+using IoService = boost::asio::io_service;
+
+/**
+ * @brief Small fixed set of event loops multiplexing all websocket feeds
+ *
+ * Each loop is an io_service run by exactly one thread, so the handlers of
+ * every connection assigned to it (parse, depth, publish) execute
+ * serially on that thread. Connections are assigned round-robin in the
+ * order they are created, which makes the feed-to-thread mapping
+ * deterministic for a given config.
+ *
+ * In busy-poll mode the threads never block in the kernel: they poll their
+ * loop (a non-blocking epoll_wait) in a spin loop, trading a full core per
+ * thread for the wake-up latency of a sleeping thread.
+ */
+class IoPool {
+public:
+    IoPool() = delete;  ///< Default constructor disabled
+
+    /**
+     * @brief Creates the event loops and starts one thread per loop
+     * @param threads Number of loops (at least 1)
+     * @param busy_poll Spin on poll() instead of sleeping in run()
+     */
+    explicit IoPool(int threads, bool busy_poll = false);
+
+    /**
+     * @brief Stops the loops if stop() was not called, then destroys them
+     * @note Endpoints own sockets and timers registered with these loops,
+     *       so the order is: stop(), destroy the endpoints, destroy the pool
+     */
+    ~IoPool();
+
+    IoPool(const IoPool&) = delete;
+    IoPool& operator=(const IoPool&) = delete;
+
+    /**
+     * @brief Stops every loop and joins its thread; later calls do nothing
+     * @note No handler runs once this returns, so the endpoints bound to
+     *       the loops can be destroyed safely
+     */
+    void stop();
+
+    /**
+     * @brief Event loop for the next connection
+     * @return Loop index assigned % size(), in round-robin order
+     */
+    IoService& next();
+
+    /// @brief Number of event loops (and I/O threads)
+    int size() const { return static_cast<int>(services_.size()); }
+
+    /// @brief Native handle of the thread running loop i, for pinning
+    pthread_t nativeHandle(int i) { return threads_[i].native_handle(); }
+
+private:
+    using WorkGuard = boost::asio::executor_work_guard<IoService::executor_type>;
+
+    std::vector<std::unique_ptr<IoService>> services_;  ///< One loop per thread
+    std::vector<WorkGuard> work_;        ///< Keep loops alive while they have no connections
+    std::vector<std::thread> threads_;   ///< Thread running each loop
+    int assigned_ = 0;                   ///< Connections handed out so far
+};
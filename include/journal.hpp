@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "orderbook.hpp"
+
+/// @brief Path of the opportunity journal
+/// @note Created if it doesn't exist, appended to otherwise
+const std::string kJournalPath = "../storage/opportunities.journal";
+
+/// @brief Identifies an opportunity journal file
+constexpr char kJournalMagic[8] = {'A', 'R', 'B', 'J', 'R', 'N', 'L', '\0'};
+
+/// @brief Layout version of the header and records; bumped on any change
+const uint32_t kJournalVersion = 1;
+
+/// @brief Records a new journal has room for before it first grows
+const uint64_t kJournalInitialRecords = 1 << 16;
+
+/// @brief Exchange and pair name slots in the header
+const int kJournalMaxNames = 8;
+
+/// @brief Bytes per exchange or pair name in the header, NUL included
+const int kJournalNameSize = 16;
+
+/// @brief Kind of opportunity a journal record holds
+enum JournalKind : uint8_t {
+    kJournalPair = 1,   ///< Cross-exchange opportunity on one pair: leg 0 buys, leg 1 sells
+    kJournalCycle = 2,  ///< Triangular cycle: three legs in trading order
+};
+
+/**
+ * @brief File header of the journal, at offset 0
+ *
+ * The exchange and pair names are copied from kExchanges and kPairs when
+ * the file is created, so records can be decoded by builds with different
+ * tables. record_count is only advanced after a record is fully written,
+ * so readers never see a torn record.
+ */
+struct JournalHeader {
+    char magic[8];                  ///< kJournalMagic
+    uint32_t version;               ///< kJournalVersion
+    uint32_t header_size;           ///< sizeof(JournalHeader), offset of record 0
+    uint32_t record_size;           ///< sizeof(JournalRecord)
+    uint32_t exchange_count;        ///< Entries used in exchanges
+    uint32_t pair_count;            ///< Entries used in pairs
+    uint32_t reserved0;
+    uint64_t record_count;          ///< Committed records; written with release, read with acquire
+    uint64_t created_ns;            ///< Creation time, nanoseconds since the epoch
+    char exchanges[kJournalMaxNames][kJournalNameSize];  ///< Exchange names by index
+    char pairs[kJournalMaxNames][kJournalNameSize];      ///< Pair names by index
+    uint8_t reserved1[208];
+};
+static_assert(sizeof(JournalHeader) == 512, "journal header layout changed, bump kJournalVersion");
+
+/**
+ * @brief One opportunity, fixed size and trivially copyable
+ *
+ * Both kinds are stored as legs: a pair opportunity buys pairs[0] on
+ * exchanges[0] and sells it on exchanges[1]; a cycle trades its three legs
+ * in order. Unused legs are zero.
+ */
+struct JournalRecord {
+    uint8_t kind;                    ///< JournalKind
+    uint8_t leg_count;               ///< 2 for pair opportunities, 3 for cycles
+    uint8_t buy_base;                ///< Bit k set when leg k buys the base on the asks
+    uint8_t reserved0;
+    uint8_t exchanges[kCycleLegs];   ///< Exchange index of each leg
+    uint8_t pairs[kCycleLegs];       ///< Pair index of each leg
+    uint16_t levels[kCycleLegs];     ///< Price levels used by each leg
+    uint8_t reserved1[8];
+    int64_t detection_time_ns;       ///< Detection time, nanoseconds since the epoch
+    double detection_latency_us;     ///< Socket receive to detection latency
+    double book_age_us[kCycleLegs];  ///< Age of each leg's book at detection
+    double vwap[2];                  ///< Buy and sell VWAP (pair opportunities only)
+    double amount;                   ///< Order size in base (pair) or start amount (cycle)
+    double end_amount;               ///< Amount the cycle returns (cycles only)
+    double profit_pct;               ///< Profit in percent after fees
+    double net_profit;               ///< Net profit in quote (pair) or start currency (cycle)
+    uint8_t reserved2[16];
+};
+static_assert(sizeof(JournalRecord) == 128, "journal record layout changed, bump kJournalVersion");
+
+/// @brief Converts a pair opportunity to its journal record
+JournalRecord toJournalRecord(const Opportunity& opp);
+
+/// @brief Converts a triangular opportunity to its journal record
+JournalRecord toJournalRecord(const CycleOpportunity& cycle);
+
+/**
+ * @brief Append-only writer of a memory-mapped journal
+ *
+ * The file is mapped shared and grown by doubling, so appending a record
+ * is a copy into a mapped page plus one store to the header's count; the
+ * kernel writes pages back in the background and they survive a crash of
+ * the process. Single writer per file.
+ */
+class JournalWriter {
+public:
+    JournalWriter() = default;
+    ~JournalWriter();
+
+    JournalWriter(const JournalWriter&) = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+
+    /**
+     * @brief Opens a journal for appending, creating it if needed
+     * @param path File to open
+     * @throws std::runtime_error if the file cannot be mapped or is not a
+     *         journal of this version
+     */
+    void open(const std::string& path);
+
+    /// @brief Appends one record, growing the file when full
+    void append(const JournalRecord& record);
+
+    /// @brief Records in the journal
+    uint64_t count() const { return count_; }
+
+private:
+    void map(uint64_t capacity);
+
+    int fd_ = -1;                       ///< Journal file
+    JournalHeader* header_ = nullptr;   ///< Start of the mapping
+    JournalRecord* records_ = nullptr;  ///< First record in the mapping
+    uint64_t capacity_ = 0;             ///< Records the file currently holds room for
+    uint64_t count_ = 0;                ///< Records written, mirrors header_->record_count
+    size_t mapped_bytes_ = 0;           ///< Size of the mapping
+};
+
+/**
+ * @brief Read-only view of a journal, safe to use while it is being written
+ *
+ * refresh() picks up records committed since the last call, remapping the
+ * file if it grew.
+ */
+class JournalReader {
+public:
+    JournalReader() = default;
+    ~JournalReader();
+
+    JournalReader(const JournalReader&) = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+
+    /**
+     * @brief Opens and maps a journal
+     * @param path File to open
+     * @return false if the file is missing, truncated or not a journal of this version
+     */
+    bool open(const std::string& path);
+
+    /// @brief Whether open() succeeded
+    bool isOpen() const { return header_ != nullptr; }
+
+    /// @brief Updates count() to the records committed so far
+    void refresh();
+
+    /// @brief Records visible since the last refresh()
+    uint64_t count() const { return count_; }
+
+    /// @brief Record i, for i < count()
+    const JournalRecord& record(uint64_t i) const { return records_[i]; }
+
+    /// @brief Header of the journal
+    const JournalHeader& header() const { return *header_; }
+
+    /// @brief Name of exchange index i, from the header
+    std::string_view exchangeName(int i) const;
+
+    /// @brief Name of pair index i, from the header
+    std::string_view pairName(int i) const;
+
+private:
+    bool map();
+
+    int fd_ = -1;                             ///< Journal file
+    const JournalHeader* header_ = nullptr;   ///< Start of the mapping
+    const JournalRecord* records_ = nullptr;  ///< First record in the mapping
+    uint64_t count_ = 0;                      ///< Records visible to record()
+    size_t mapped_bytes_ = 0;                 ///< Size of the mapping
+};
+
+/**
+ * @brief Writes a record in the human-readable format of the opportunity log
+ * @param out Destination stream
+ * @param reader Journal the record belongs to, for exchange and pair names
+ * @param record Record to format
+ */
+void formatText(std::ostream& out, const JournalReader& reader, const JournalRecord& record);
+
+/// @brief Writes the column names matching formatCsv()
+void formatCsvHeader(std::ostream& out);
+
+/**
+ * @brief Writes a record as one CSV row
+ * @param out Destination stream
+ * @param reader Journal the record belongs to, for exchange and pair names
+ * @param index Index of the record in the journal
+ * @param record Record to format
+ */
+void formatCsv(std::ostream& out, const JournalReader& reader, uint64_t index, const JournalRecord& record);
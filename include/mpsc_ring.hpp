@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "affinity.hpp"
+
+/**
+ * @brief Bounded lock-free multi-producer single-consumer ring buffer
+ *
+ * Each slot carries its own sequence number (Vyukov's bounded queue), so
+ * producers claim slots with a single CAS on the tail and never wait on each
+ * other or on the consumer. When the ring is full the push fails and is
+ * counted instead of blocking the producer.
+ *
+ * The consumer can either poll with tryPop(), spin in spinPop(), or block in
+ * pop(), which parks on an atomic counter and is woken by the next push.
+ *
+ * @tparam T Element type (copied in and out)
+ * @tparam Capacity Number of slots, must be a power of two
+ */
+template <typename T, size_t Capacity>
+class MpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    MpscRing() {
+        for (size_t i = 0; i < Capacity; i++)
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    /**
+     * @brief Enqueues an element without blocking (any thread)
+     * @param value Element to enqueue
+     * @return false if the ring was full and the element was dropped
+     */
+    bool tryPush(const T& value) {
+        uint64_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos & kMask];
+            uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        Slot& slot = slots_[pos & kMask];
+        slot.value = value;
+        slot.seq.store(pos + 1, std::memory_order_release);
+        pushed_.fetch_add(1, std::memory_order_release);
+        pushed_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Dequeues an element if one is ready (consumer thread only)
+     * @param out Destination for the element
+     * @return false if the ring was empty
+     */
+    bool tryPop(T& out) {
+        Slot& slot = slots_[head_ & kMask];
+        if (slot.seq.load(std::memory_order_acquire) != head_ + 1)
+            return false;
+        out = slot.value;
+        slot.seq.store(head_ + Capacity, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+
+    /**
+     * @brief Dequeues an element, sleeping until one is available (consumer thread only)
+     * @param out Destination for the element
+     */
+    void pop(T& out) {
+        while (!tryPop(out)) {
+            uint64_t pushed = pushed_.load(std::memory_order_acquire);
+            if (pushed == head_)
+                pushed_.wait(pushed, std::memory_order_acquire);
+        }
+    }
+
+    /**
+     * @brief Dequeues an element, spinning until one is available (consumer thread only)
+     *
+     * Never sleeps, so there is no wake-up latency; costs a full core.
+     *
+     * @param out Destination for the element
+     */
+    void spinPop(T& out) {
+        while (!tryPop(out))
+            cpuRelax();
+    }
+
+    /// @brief Number of pushes rejected because the ring was full
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint64_t kMask = Capacity - 1;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> seq;  ///< Slot state: pos when free, pos + 1 when filled
+        T value;                    ///< Stored element
+    };
+
+    Slot slots_[Capacity];                        ///< Ring storage
+    alignas(64) std::atomic<uint64_t> tail_{0};   ///< Next position claimed by producers
+    alignas(64) std::atomic<uint64_t> pushed_{0}; ///< Completed pushes, used to park the consumer
+    std::atomic<uint64_t> dropped_{0};            ///< Pushes rejected on overflow
+    alignas(64) uint64_t head_{0};                ///< Next position read by the consumer
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <simdjson.h>
+#include <websocketpp/common/memory.hpp>
+#include <websocketpp/frame.hpp>
+
+/// @brief Messages kept per connection for reuse
+const size_t kMaxPooledMessages = 16;
+
+/// @brief Payload capacity above which a buffer is released instead of kept
+const size_t kMaxPooledCapacity = 1 << 20;
+
+/**
+ * @brief websocketpp per-connection message manager that reuses messages
+ *
+ * Drop-in replacement for message_buffer::alloc::con_msg_manager. Incoming
+ * frames are assembled into messages taken from a small per-connection
+ * pool, and each payload buffer keeps SIMDJSON_PADDING bytes of spare
+ * capacity. simdjson can then parse the payload in place
+ * (parser::iterate(std::string&) only copies when padding is missing), and
+ * in steady state receiving a message allocates nothing.
+ *
+ * A pooled message is free again once the pool holds its only reference.
+ * All users of a connection's messages run on that connection's strand,
+ * so the reference count is not raced.
+ *
+ * @tparam message websocketpp message type using this manager
+ */
+template <typename message>
+class PooledConMsgManager
+    : public websocketpp::lib::enable_shared_from_this<PooledConMsgManager<message>> {
+public:
+    typedef PooledConMsgManager<message> type;
+    typedef websocketpp::lib::shared_ptr<type> ptr;
+    typedef websocketpp::lib::weak_ptr<type> weak_ptr;
+    typedef typename message::ptr message_ptr;
+
+    /// @brief Gets an empty message (outgoing messages)
+    message_ptr get_message() {
+        return get_message(websocketpp::frame::opcode::text, 0);
+    }
+
+    /**
+     * @brief Gets a message able to hold size bytes plus simdjson padding
+     * @param op Opcode of the message
+     * @param size Expected payload size
+     */
+    message_ptr get_message(websocketpp::frame::opcode::value op, size_t size) {
+        for (message_ptr& pooled : pool_) {
+            if (pooled.use_count() != 1)
+                continue;
+            reset(*pooled, op, size);
+            return pooled;
+        }
+        message_ptr msg = websocketpp::lib::make_shared<message>(this->shared_from_this(), op,
+                                                                  size + simdjson::SIMDJSON_PADDING);
+        if (pool_.size() < kMaxPooledMessages)
+            pool_.push_back(msg);
+        return msg;
+    }
+
+    /// @brief Recycling is done through reference counts, not by messages
+    bool recycle(message*) { return false; }
+
+private:
+    /// @brief Restores a pooled message to the state of a newly created one
+    void reset(message& msg, websocketpp::frame::opcode::value op, size_t size) {
+        msg.set_opcode(op);
+        msg.set_header("");
+        msg.set_prepared(false);
+        msg.set_compressed(false);
+        msg.set_terminal(false);
+        msg.set_fin(true);
+
+        std::string& payload = msg.get_raw_payload();
+        size_t needed = size + simdjson::SIMDJSON_PADDING;
+        if (payload.capacity() > kMaxPooledCapacity && needed <= kMaxPooledCapacity)
+            std::string().swap(payload);
+        payload.clear();
+        payload.reserve(needed);
+    }
+
+    std::vector<message_ptr> pool_;  ///< Messages owned by this connection, free when unshared
+};
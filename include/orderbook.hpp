@@ -1,11 +1,27 @@
 #pragma once
 
 #include <chrono>
+#include <vector>
+#include "mpsc_ring.hpp"
+#include "seqlock.hpp"
+#include "spsc_ring.hpp"
 #include "utils.hpp"
 
 /// @brief Maximum size of the orderbook (number of price levels)
 const int kMaxSize = 50;
 
+/// @brief Capacity of the feed-to-detector event queue (power of two)
+const int kEventQueueSize = 1024;
+
+/// @brief Price in integer ticks of the instrument (10^-price_decimals)
+using Ticks = int64_t;
+
+/// @brief Quantity in integer lots of the instrument (10^-qty_decimals)
+using Lots = int64_t;
+
+/// @brief Notional in ticks * lots
+using Notional = int64_t;
+
 /**
  * @brief Level 2 Orderbook structure
  * 
@@ -15,19 +31,119 @@ const int kMaxSize = 50;
  * Memory layout is optimized for sequential access:
  * - Ask and bid arrays are grouped together
  * - Price and quantity arrays are adjacent for each side
+ * - Cumulative (prefix) arrays follow the raw levels
  * - Control variables are placed at the end
+ *
+ * Prices and quantities are fixed-point integers in the scale recorded in
+ * the book, so all detection math is exact and replay-deterministic.
+ *
+ * The cumulative arrays are filled once per update by the producer (see
+ * computeDepth), so the detector only merges precomputed prefixes.
+ *
+ * Books are shared between threads only through PublishedBook, never by
+ * writing into a shared instance in place.
  */
 struct alignas(64) L2OrderBook {
-    double askQuantity[kMaxSize];  ///< Quantities available at ask prices
-    double askPrice[kMaxSize];     ///< Ask prices sorted in ascending order
-    double bidQuantity[kMaxSize];  ///< Quantities available at bid prices
-    double bidPrice[kMaxSize];     ///< Bid prices sorted in descending order
-    std::chrono::high_resolution_clock::time_point t;  ///< Timestamp of last update
+    Lots askQuantity[kMaxSize];    ///< Quantities available at ask prices
+    Ticks askPrice[kMaxSize];      ///< Ask prices sorted in ascending order
+    Lots bidQuantity[kMaxSize];    ///< Quantities available at bid prices
+    Ticks bidPrice[kMaxSize];      ///< Bid prices sorted in descending order
+    Lots askCumQty[kMaxSize];      ///< Cumulative ask quantity, capped at the order size limit
+    Notional askCumCost[kMaxSize]; ///< Cumulative ask notional matching askCumQty
+    Lots bidCumQty[kMaxSize];      ///< Cumulative bid quantity, capped at the order size limit
+    Notional bidCumCost[kMaxSize]; ///< Cumulative bid notional matching bidCumQty
+    std::chrono::high_resolution_clock::time_point t;  ///< Timestamp of last update (start of message handling)
+    std::chrono::high_resolution_clock::time_point rxTime;  ///< Socket receive timestamp of the update's last bytes
     int askSize;                   ///< Number of valid ask price levels
     int bidSize;                   ///< Number of valid bid price levels
-    bool newData;                  ///< Flag indicating new data is available
+    int askDepth;                  ///< Number of valid entries in askCumQty/askCumCost
+    int bidDepth;                  ///< Number of valid entries in bidCumQty/bidCumCost
+    Scale scale;                   ///< Fixed-point scale of prices and quantities
+};
+
+/**
+ * @brief Age of a book, from its socket receive timestamp
+ * @param ob Book to measure
+ * @param now Time the book is used at
+ * @return Age in microseconds, 0 if the book was received after now
+ */
+inline int64_t bookAgeUs(const L2OrderBook& ob, std::chrono::high_resolution_clock::time_point now) {
+    return now < ob.rxTime ? 0 : std::chrono::duration_cast<std::chrono::microseconds>(now - ob.rxTime).count();
+}
+
+/**
+ * @brief Whether a book is too old to trade against
+ * @param age_us Age of the book from bookAgeUs()
+ * @param max_age_ms Age limit of the book's venue, 0 for no limit
+ */
+inline bool isStale(int64_t age_us, double max_age_ms) {
+    return max_age_ms > 0.0 && static_cast<double>(age_us) > max_age_ms * 1000.0;
+}
+
+/// @brief Converts ticks of a book to a price in quote currency
+inline double toPrice(const L2OrderBook& ob, Ticks ticks) {
+    return static_cast<double>(ticks) / kPow10[ob.scale.price_decimals];
+}
+
+/// @brief Converts lots of a book to a quantity in base currency
+inline double toQuantity(const L2OrderBook& ob, Lots lots) {
+    return static_cast<double>(lots) / kPow10[ob.scale.qty_decimals];
+}
+
+/// @brief Converts ticks * lots of a book to a notional in quote currency
+inline double toNotional(const L2OrderBook& ob, Notional notional) {
+    return static_cast<double>(notional) / kPow10[ob.scale.price_decimals + ob.scale.qty_decimals];
+}
+
+/**
+ * @brief Builds the cumulative quantity/notional arrays of an orderbook
+ *
+ * Walks each side from the top level, accumulating quantity and notional
+ * until max_lots is reached; the level that crosses the limit is only
+ * partially taken. Sets askDepth/bidDepth to the number of levels used.
+ *
+ * A side whose worst-case notional (max_lots at its highest price) would
+ * overflow Notional is left empty (depth 0).
+ *
+ * @param ob Orderbook whose raw levels are already filled
+ * @param max_lots Maximum order size in lots of the book's scale
+ * @return false if a side was left empty because of overflow
+ */
+bool computeDepth(L2OrderBook& ob, Lots max_lots);
+
+/// @brief Orderbook published by a feed and read torn-free by consumers
+/// @note The seqlock version replaces the old newData flag
+using PublishedBook = SeqLock<L2OrderBook>;
+
+/**
+ * @brief Notification that a feed published a new orderbook version
+ *
+ * Pushed by wsClient after every publish so process() knows exactly which
+ * book changed and when its data was received.
+ */
+struct BookEvent {
+    int exchange;       ///< Index of the exchange whose book was updated
+    int pair;           ///< Index of the trading pair
+    uint64_t sequence;  ///< Seqlock version the update was published as
+    std::chrono::high_resolution_clock::time_point t;  ///< Socket receive timestamp of the update
 };
 
+/// @brief Queue carrying book updates from the feeds of one pair to its worker
+using BookEventQueue = MpscRing<BookEvent, kEventQueueSize>;
+
+/// @brief Exchange index of the event that makes a detector return
+const int kStopEvent = -1;
+
+/**
+ * @brief Queues the event that stops the detector reading a queue
+ *
+ * The detector returns once it pops it, after every update queued before.
+ * Waits while the queue is full; call it once the feeds are stopped.
+ *
+ * @param events Event queue of a pair worker or of the cycle detector
+ */
+void queueStop(BookEventQueue& events);
+
 /**
  * @brief Structure representing an arbitrage opportunity
  * 
@@ -43,29 +159,153 @@ struct alignas(64) L2OrderBook {
 struct alignas(64) Opportunity {
     int buy_exchange;    ///< Index of the exchange to buy from
     int sell_exchange;   ///< Index of the exchange to sell on
+    int pair;            ///< Index of the trading pair in kPairs
     int buy_levels;      ///< Number of price levels needed for buy
     int sell_levels;     ///< Number of price levels needed for sell
     double buy_vwap;     ///< Volume-weighted average price for buy
     double sell_vwap;    ///< Volume-weighted average price for sell
     double profit_pct;   ///< Expected profit percentage
     double order_size;   ///< Size of the order in base currency
-    double detection_latency_us;  ///< Detection latency in microseconds
+    double net_profit;   ///< Expected profit after fees, in quote currency
+    double detection_latency_us;  ///< Socket receive to detection latency in microseconds
+    double buy_book_age_us;       ///< Age of the buy book at detection, from its socket receive time
+    double sell_book_age_us;      ///< Age of the sell book at detection, from its socket receive time
     std::chrono::high_resolution_clock::time_point detection_time;  ///< When opportunity was detected
 };
 
+/// @brief Number of legs of a triangular cycle
+const int kCycleLegs = 3;
+
 /**
- * @brief Process orderbooks to find arbitrage opportunities
- * 
- * This function continuously monitors orderbooks from multiple exchanges and
- * identifies profitable arbitrage opportunities using VWAP calculations.
- * 
- * @param orderbooks Vector of orderbooks from different exchanges
- * @param cfg Trading configuration parameters
- * @param out_opps Vector to store found opportunities
- * @param new_ob Reference to store the latest processed orderbook
- * @note Thread-safe through semaphore synchronization
+ * @brief Structure representing a triangular arbitrage opportunity
+ *
+ * The start currency is converted through three books and back into
+ * itself. Leg k trades pairs[k] on exchanges[k], spending the quote for
+ * the base on the asks when buy_base[k] is set and selling the base on
+ * the bids otherwise. Legs may be on one exchange or on several.
  */
-void process(std::vector<L2OrderBook>& orderbooks, config& cfg, std::vector<Opportunity>& out_opps, L2OrderBook& new_ob);
+struct alignas(64) CycleOpportunity {
+    int exchanges[kCycleLegs];  ///< Exchange index of each leg
+    int pairs[kCycleLegs];      ///< Pair index of each leg
+    bool buy_base[kCycleLegs];  ///< Whether each leg buys (asks) or sells (bids) the pair's base
+    int levels[kCycleLegs];     ///< Number of price levels used by each leg
+    double start_amount;        ///< Start currency put into the first leg
+    double end_amount;          ///< Start currency received from the last leg, after fees
+    double profit_pct;          ///< Net profit relative to start_amount
+    double net_profit;          ///< end_amount - start_amount, in the start currency
+    double detection_latency_us;  ///< Socket receive to detection latency in microseconds
+    double book_age_us[kCycleLegs];  ///< Age of each leg's book at detection
+    std::chrono::high_resolution_clock::time_point detection_time;  ///< When the cycle was detected
+};
+
+/// @brief One breakpoint of a profit-vs-size curve
+struct ProfitPoint {
+    double size;        ///< Order size in base currency
+    double net_profit;  ///< Net profit after fees at this size
+};
+
+/// @brief Maximum number of points solveBestSize() writes to a curve
+const int kMaxCurvePoints = 2 * kMaxSize;
+
+/// @brief Denominator of fee multipliers (fees are applied in parts per kFeeDen)
+const int64_t kFeeDen = 1000000;
+
+/**
+ * @brief Converts a fee in percent to the integer form used by the solver
+ * @param fee_pct Fee in percent
+ * @return Fee in parts per kFeeDen
+ */
+inline int64_t feeUnits(double fee_pct) {
+    return static_cast<int64_t>(fee_pct / 100.0 * kFeeDen + 0.5);
+}
+
+/**
+ * @brief Finds the order size that maximizes net profit between two books
+ *
+ * Net profit of buying q on the buy book's asks and selling q on the sell
+ * book's bids is revenue(q) - cost(q) * (1 + fee). It is piecewise linear
+ * and concave (marginal bids fall, marginal asks rise), so the optimum is
+ * the last level boundary where the marginal bid still beats the marginal
+ * ask after fees. Uses the cumulative arrays built by computeDepth(); both
+ * books must share the same scale.
+ *
+ * The search is pure integer math: prices are compared as
+ * bid * kFeeDen vs ask * (kFeeDen + fee) and profits are accumulated in
+ * 128-bit, so no division happens until the result is converted.
+ *
+ * @param buy Book to buy on (ask side)
+ * @param sell Book to sell on (bid side)
+ * @param fee Combined fees of both exchanges, from feeUnits()
+ * @param min_profit Minimum net profit (quote currency) for the result to be reported
+ * @param best Filled with levels, VWAPs, size and profit of the optimum;
+ *        exchange indices and timing are left to the caller
+ * @param curve Optional output for every breakpoint, at least kMaxCurvePoints long
+ * @param curve_n Optional output for the number of points written to curve
+ * @return true if the optimal size clears min_profit
+ */
+bool solveBestSize(const L2OrderBook& buy, const L2OrderBook& sell, int64_t fee,
+                   double min_profit, Opportunity& best,
+                   ProfitPoint* curve = nullptr, int* curve_n = nullptr);
+
+class WorkStealingPool;
+
+/// @brief One (buy exchange, sell exchange) combination evaluated on an update
+struct ExchangePair {
+    int buy;      ///< Index of the book bought on (asks)
+    int sell;     ///< Index of the book sold on (bids)
+    int64_t fee;  ///< Combined fees of both exchanges, from feeUnits()
+};
+
+/**
+ * @brief Collects the exchange pairs of one update worth detecting
+ *
+ * Keeps the pairs of enabled exchanges with asks on the buy book and bids
+ * on the sell book, in incremental mode only those that include the
+ * updated book. Pairs with a stale side are counted and left out.
+ *
+ * @param books Books of one trading pair, indexed by exchange
+ * @param updated Exchange of the book that triggered the update
+ * @param cfg Configuration; exchanges and incremental are read
+ * @param fees Combined fees of each (buy, sell) exchange pair, from feeUnits()
+ * @param stale Whether each exchange's book is past its age limit
+ * @param out Cleared, then filled with the pairs in (buy, sell) order
+ * @return Number of pairs skipped because a book was stale
+ */
+uint64_t selectPairs(const L2OrderBook* books, int updated, const config& cfg,
+                     const int64_t (*fees)[kTotalExchanges], const bool* stale,
+                     std::vector<ExchangePair>& out);
+
+/// @brief Output of one detectPairs() participant, padded against false sharing
+struct alignas(64) DetectLane {
+    std::vector<Opportunity> found;  ///< Opportunities found by this participant
+    uint64_t pruned = 0;             ///< Pairs rejected by the top-of-book filter
+};
+
+/**
+ * @brief Evaluates a batch of exchange pairs against the same books
+ *
+ * Rejects a pair from top of book alone when min_profit is positive and the
+ * best bid does not beat the best ask after fees, and runs solveBestSize()
+ * on the rest. Batches of at least min_parallel pairs are split across the
+ * pool; results are merged in (buy, sell) order, so the output does not
+ * depend on how the batch was scheduled.
+ *
+ * @param books Books indexed by the buy and sell fields of pairs
+ * @param pairs Exchange pairs to evaluate
+ * @param count Number of pairs
+ * @param min_profit Minimum net profit (quote currency) to report
+ * @param received Receive time of the update, detection latency is measured from it
+ * @param pool Pool for large batches, nullptr to always run serially
+ * @param min_parallel Smallest batch run on the pool
+ * @param lanes Scratch outputs, at least pool->size() entries (1 without a pool)
+ * @param out Cleared, then filled with the opportunities; buy_exchange and
+ *        sell_exchange are the pair's book indices, timing is set
+ * @return Number of pairs pruned by the top-of-book filter
+ */
+uint64_t detectPairs(const L2OrderBook* books, const ExchangePair* pairs, int count, double min_profit,
+                     std::chrono::high_resolution_clock::time_point received,
+                     WorkStealingPool* pool, int min_parallel,
+                     std::vector<DetectLane>& lanes, std::vector<Opportunity>& out);
 
 /**
  * @brief Performance metrics tracking structure
@@ -80,6 +320,11 @@ void process(std::vector<L2OrderBook>& orderbooks, config& cfg, std::vector<Oppo
 struct alignas(64) Metrics {
     std::atomic<uint64_t> updates_processed{0};    ///< Total number of orderbook updates processed
     std::atomic<uint64_t> opportunities_found{0};  ///< Total number of opportunities detected
+    std::atomic<uint64_t> updates_superseded{0};   ///< Updates overwritten before they were processed
+    std::atomic<uint64_t> pairs_pruned{0};         ///< Exchange pairs rejected by the top-of-book filter
+    std::atomic<uint64_t> stale_skipped{0};        ///< Exchange pairs skipped because a book exceeded its venue's age limit
+    std::atomic<uint64_t> rx_delay_total_us{0};    ///< Cumulative socket receive to message handler delay
+    std::atomic<uint64_t> rx_delay_samples{0};     ///< Messages contributing to rx_delay_total_us
     std::atomic<uint64_t> total_latency_us{0};     ///< Cumulative latency for statistics
     std::atomic<uint64_t> max_latency_us{0};       ///< Maximum observed latency
     std::atomic<uint64_t> min_latency_us{std::numeric_limits<uint64_t>::max()};  ///< Minimum observed latency
@@ -108,15 +353,176 @@ struct alignas(64) Metrics {
     }
 };
 
+/**
+ * @brief Books and book events of one trading pair
+ *
+ * Detection is partitioned by pair: each pair has a publication slot per
+ * exchange, its own event queue and its own process() worker, so pairs are
+ * detected on separate cores without sharing queues or counters.
+ */
+struct PairBooks {
+    PublishedBook books[kTotalExchanges];  ///< Latest book of the pair on each exchange
+    BookEventQueue events;                 ///< Updates of books, pushed by this pair's feeds
+    Metrics metrics;                       ///< Detection statistics of this pair's worker
+    BookEventQueue* cycle_events = nullptr;  ///< Queue of the cycle detector, set if the pair is a cycle leg
+};
+
+/**
+ * @brief Publishes a freshly parsed book and notifies its detectors
+ *
+ * The ingestion step shared by the live feeds and replay: builds the
+ * book's cumulative arrays, publishes it through its seqlock and queues an
+ * update event for the pair's worker and, if the pair is a cycle leg, for
+ * the cycle detector.
+ *
+ * @param exchange Index of the book's exchange
+ * @param pair Index of the book's pair
+ * @param ob Book with its raw levels, scale and timestamps filled
+ * @param max_lots Order size limit in lots of the book's scale
+ * @param slot Publication slot of the (exchange, pair) book
+ * @param events Event queue of the pair's worker
+ * @param cycle_events Event queue of the cycle detector, nullptr if the pair is not a cycle leg
+ * @return false if computeDepth() left a side empty because of overflow
+ */
+bool ingestBook(int exchange, int pair, L2OrderBook& ob, Lots max_lots, PublishedBook& slot,
+                BookEventQueue& events, BookEventQueue* cycle_events);
+
+/// @brief Top of book of one processed update, as stored in the database
+struct BookSummary {
+    int exchange;        ///< Index of the exchange whose book was updated
+    int pair;            ///< Index of the trading pair
+    std::chrono::high_resolution_clock::time_point t;  ///< Timestamp of the update
+    double topAsk;       ///< Best ask price
+    double topAskQty;    ///< Quantity at the best ask
+    double topBid;       ///< Best bid price
+    double topBidQty;    ///< Quantity at the best bid
+};
+
+/// @brief Capacity of each pair worker's opportunity ring (power of two)
+const size_t kOpportunityRingSize = 4096;
+
+/// @brief Capacity of each pair worker's book summary ring (power of two)
+const size_t kSummaryRingSize = 8192;
+
+/// @brief Capacity of the cycle detector's opportunity ring (power of two)
+const size_t kCycleRingSize = 4096;
+
+/**
+ * @brief Hand-off of detection results from the detector threads to dbWriterThread
+ *
+ * Every pair worker has its own preallocated opportunity and summary rings,
+ * and the cycle detector has one for its cycles, so each ring has a single
+ * producer and a single consumer and no detector shares a cache line or a
+ * lock with another or with the writer. Publishing copies into the rings
+ * and bumps a counter the writer sleeps on; it never allocates or waits.
+ * A record published into a ring is drained exactly once. When the writer
+ * falls far enough behind to fill a ring, new records are dropped and
+ * counted per ring type instead of stalling detection.
+ */
+class OpportunitySink {
+public:
+    /**
+     * @brief Adds the results of one processed update (the pair's worker thread only)
+     * @param pair Index of the pair whose worker is publishing
+     * @param opps Opportunities found on the update, possibly none
+     * @param summary Top of book of the updated book
+     */
+    void publish(int pair, const std::vector<Opportunity>& opps, const BookSummary& summary);
+
+    /**
+     * @brief Adds triangular opportunities (cycle detector thread only)
+     * @param cycles Cycles found on one update
+     */
+    void publishCycles(const std::vector<CycleOpportunity>& cycles);
+
+    /**
+     * @brief Waits for results and moves all pending ones out (writer thread)
+     * @param opps Cleared, then filled with pending opportunities
+     * @param summaries Cleared, then filled with pending book summaries
+     * @param cycles Cleared, then filled with pending triangular opportunities
+     * @param busy_poll Spin with pause hints instead of sleeping while empty
+     * @param deadline Time to give up waiting at, time_point::max() to wait indefinitely
+     * @return false if the deadline passed, or the sink is closed, with nothing pending
+     */
+    bool drain(std::vector<Opportunity>& opps, std::vector<BookSummary>& summaries,
+               std::vector<CycleOpportunity>& cycles, bool busy_poll,
+               std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+    /**
+     * @brief Marks the end of results and wakes the writer
+     *
+     * Call once every publisher has returned; drain() then returns false
+     * as soon as nothing is pending, whatever its deadline.
+     */
+    void close();
+
+    /// @brief Whether close() was called
+    bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+    /// @brief Opportunities dropped on full rings
+    uint64_t droppedOpportunities() const;
+
+    /// @brief Book summaries dropped on full rings
+    uint64_t droppedSummaries() const;
+
+    /// @brief Triangular opportunities dropped on a full ring
+    uint64_t droppedCycles() const { return cycles_.dropped(); }
+
+private:
+    /// @brief Longest sleep of a drain with a deadline between checks of the rings
+    static constexpr std::chrono::milliseconds kDeadlinePollInterval{1};
+
+    /// @brief Moves everything the rings hold into the outputs, true if anything was moved
+    bool collect(std::vector<Opportunity>& opps, std::vector<BookSummary>& summaries,
+                 std::vector<CycleOpportunity>& cycles);
+
+    SpscRing<Opportunity, kOpportunityRingSize> opps_[kTotalPairs];   ///< Opportunities, one ring per pair worker
+    SpscRing<BookSummary, kSummaryRingSize> summaries_[kTotalPairs];  ///< Book summaries, one ring per pair worker
+    SpscRing<CycleOpportunity, kCycleRingSize> cycles_;               ///< Triangular opportunities
+    alignas(64) std::atomic<uint64_t> published_{0};  ///< Publishes so far, used to park the writer
+    std::atomic<bool> closed_{false};                 ///< Set by close(), no publish follows
+};
+
+/**
+ * @brief Process the orderbooks of one pair to find arbitrage opportunities
+ * 
+ * This function continuously monitors the pair's orderbooks on every
+ * exchange and identifies profitable arbitrage opportunities using VWAP
+ * calculations. One worker runs per enabled pair.
+ * Each event from the pair's queue is processed against the exact book
+ * version it announces; events whose book was already overwritten are
+ * counted as superseded, since the newer version has its own event queued
+ * behind them. Exchange pairs involving a book older than its venue's
+ * cfg.max_book_age_ms are skipped and counted as stale. With
+ * cfg.detect_threads set, updates with at least cfg.detect_min_pairs
+ * exchange pairs to evaluate are split across a private work-stealing pool.
+ * 
+ * @param pair Index of the trading pair in kPairs
+ * @param market Books, event queue and metrics of the pair
+ * @param cfg Trading configuration parameters
+ * @param sink Destination of opportunities and processed book summaries
+ * @note Books are read through their seqlock, so a snapshot is never torn
+ * @note Spins on the event queue instead of sleeping when
+ *       cfg.low_latency.busy_poll is set
+ * @note Returns on the event queued by queueStop()
+ */
+void process(int pair, PairBooks& market, config& cfg, OpportunitySink& sink);
+
 /**
  * @brief Database writer thread function
  * 
- * Continuously writes orderbook summaries and opportunities to persistent storage:
+ * Continuously writes orderbook summaries and opportunities of all pairs
+ * to persistent storage:
  * - Orderbook metrics to SQLite database
- * - Opportunity details to text file
+ * - Opportunity records to the memory-mapped journal (kJournalPath)
+ * 
+ * Summaries are inserted with one prepared statement into a transaction
+ * that is committed by row count or age (cfg.db), on a WAL database.
+ * Once the sink is closed, everything still pending is written, the open
+ * transaction is committed and the database is closed.
  * 
- * @param opportunities Vector of opportunities to write
- * @param ob Latest orderbook state to summarize
- * @return -1 on error, never returns on success
+ * @param sink Results published by the pair workers
+ * @param cfg Trading configuration; uses cfg.db and cfg.low_latency.busy_poll
+ * @return -1 on error, 0 once the closed sink is fully written
  */
-int dbWriterThread(std::vector<Opportunity>& opportunities, L2OrderBook& ob);
\ No newline at end of file
+int dbWriterThread(OpportunitySink& sink, const config& cfg);
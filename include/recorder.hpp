@@ -0,0 +1,285 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mpsc_ring.hpp"
+#include "orderbook.hpp"
+#include "utils.hpp"
+
+/// @brief Identifies a book recording file
+constexpr char kRecordingMagic[8] = {'A', 'R', 'B', 'L', '2', 'R', 'E', 'C'};
+
+/// @brief Layout version of the header and chunk encoding; bumped on any change
+const uint32_t kRecordingVersion = 2;
+
+/// @brief Marks the start of every chunk ("CHNK" little-endian)
+const uint32_t kRecordingChunkMagic = 0x4B4E4843;
+
+/// @brief Books per chunk; a chunk is also closed after kRecordingFlushInterval
+const int kRecordingChunkBooks = 1024;
+
+/// @brief Longest time a recorded book waits in memory before reaching the file
+constexpr std::chrono::milliseconds kRecordingFlushInterval{1000};
+
+/// @brief Capacity of the feed-to-recorder queue (power of two)
+const int kRecordingRingSize = 2048;
+
+/// @brief Exchange and pair name slots in the header
+const int kRecordingMaxNames = 8;
+
+/// @brief Bytes per exchange or pair name in the header, NUL included
+const int kRecordingNameSize = 16;
+
+/// @brief Encoded columns of a chunk, in file order
+enum RecordingColumn {
+    kColumnMeta,        ///< Exchange, pair, price and quantity decimals, level counts: six bytes per book
+    kColumnTime,        ///< Handler time delta and receive-to-handler delay, zigzag varints
+    kColumnPrice,       ///< Top of book delta and level gaps, zigzag varints
+    kColumnQuantity,    ///< Level quantities, varints with 0 for an unchanged level
+    kRecordingColumns
+};
+
+/**
+ * @brief File header of a recording, at offset 0
+ *
+ * The exchange and pair names are copied from kExchanges and kPairs when
+ * the file is created, so recordings can be read by builds with different
+ * tables. Chunks follow back to back.
+ */
+struct RecordingHeader {
+    char magic[8];                  ///< kRecordingMagic
+    uint32_t version;               ///< kRecordingVersion
+    uint32_t header_size;           ///< sizeof(RecordingHeader), offset of the first chunk
+    uint32_t exchange_count;        ///< Entries used in exchanges
+    uint32_t pair_count;            ///< Entries used in pairs
+    uint64_t created_ns;            ///< Creation time, nanoseconds since the epoch
+    char exchanges[kRecordingMaxNames][kRecordingNameSize];  ///< Exchange names by index
+    char pairs[kRecordingMaxNames][kRecordingNameSize];      ///< Pair names by index
+    uint8_t reserved[224];
+};
+static_assert(sizeof(RecordingHeader) == 512, "recording header layout changed, bump kRecordingVersion");
+
+/**
+ * @brief Header of one chunk, followed by its columns in RecordingColumn order
+ *
+ * Every price of the chunk is a multiple of 10^price_exp and every
+ * quantity a multiple of 10^qty_exp; both are divided out before
+ * encoding, which removes the padding zeros of fixed-point scales wider
+ * than the feed's own precision.
+ */
+struct RecordingChunkHeader {
+    uint32_t magic;                                 ///< kRecordingChunkMagic
+    uint32_t count;                                 ///< Books in the chunk
+    int64_t first_t_ns;                             ///< Handler time of the first book
+    int64_t last_t_ns;                              ///< Handler time of the last book
+    uint8_t price_exp;                              ///< Power of ten divided out of every price
+    uint8_t qty_exp;                                ///< Power of ten divided out of every quantity
+    uint16_t reserved0;
+    uint32_t column_bytes[kRecordingColumns];       ///< Encoded size of each column
+    uint32_t reserved1;
+};
+static_assert(sizeof(RecordingChunkHeader) == 48, "chunk header layout changed, bump kRecordingVersion");
+
+/**
+ * @brief Raw levels of one book update, as handed to the recorder
+ *
+ * Holds what the feed delivered and nothing derived from it: the
+ * cumulative arrays are rebuilt by computeDepth() on replay.
+ */
+struct RecordedBook {
+    int64_t t_ns;                   ///< Start of message handling, nanoseconds since the epoch
+    int64_t rx_ns;                  ///< Socket receive time, nanoseconds since the epoch
+    uint8_t exchange;               ///< Index of the exchange in the recording's names
+    uint8_t pair;                   ///< Index of the pair in the recording's names
+    uint8_t price_decimals;         ///< Scale of askPrice and bidPrice
+    uint8_t qty_decimals;           ///< Scale of askQuantity and bidQuantity
+    uint16_t askSize;               ///< Valid ask levels
+    uint16_t bidSize;               ///< Valid bid levels
+    Ticks askPrice[kMaxSize];       ///< Ask prices, ascending
+    Lots askQuantity[kMaxSize];     ///< Ask quantities
+    Ticks bidPrice[kMaxSize];       ///< Bid prices, descending
+    Lots bidQuantity[kMaxSize];     ///< Bid quantities
+};
+
+/**
+ * @brief Copies the raw levels and timestamps of a book for recording
+ * @param exchange Index of the exchange in kExchanges
+ * @param pair Index of the pair in kPairs
+ * @param ob Book as published
+ */
+RecordedBook toRecordedBook(int exchange, int pair, const L2OrderBook& ob);
+
+/**
+ * @brief Restores the levels, scale and timestamps of a recorded book
+ *
+ * The depth fields are left untouched; call computeDepth() before
+ * detecting on the book.
+ */
+void toL2OrderBook(const RecordedBook& book, L2OrderBook& ob);
+
+/**
+ * @brief Chunked columnar writer of book recordings
+ *
+ * Books are buffered until a chunk is full or flush() is called, then
+ * encoded column by column: the first price of each side as a delta from
+ * the same side of the previous book of its (exchange, pair) in the chunk,
+ * every further level as the gap from the level before it, and quantities
+ * as varints, or a single 0 byte where the previous book of the stream had
+ * the same quantity at the same price. Chunks are self-contained, so a
+ * file cut short loses at most its last chunk. Single writer per file.
+ */
+class RecordingWriter {
+public:
+    RecordingWriter() = default;
+
+    RecordingWriter(const RecordingWriter&) = delete;
+    RecordingWriter& operator=(const RecordingWriter&) = delete;
+
+    /**
+     * @brief Creates a recording, replacing any file at path
+     * @param path File to create
+     * @throws std::runtime_error if the file cannot be created
+     */
+    void open(const std::string& path);
+
+    /// @brief Buffers one book, writing the chunk once it holds kRecordingChunkBooks
+    void append(const RecordedBook& book);
+
+    /// @brief Encodes and writes the buffered books as one chunk, if any
+    void flush();
+
+    /// @brief Books buffered and not yet written
+    size_t pending() const { return books_.size(); }
+
+    /// @brief Books written to the file
+    uint64_t booksWritten() const { return books_written_; }
+
+    /// @brief Bytes written to the file, header included
+    uint64_t bytesWritten() const { return bytes_written_; }
+
+private:
+    std::ofstream out_;                                ///< Recording file
+    std::vector<RecordedBook> books_;                  ///< Books of the open chunk
+    std::vector<uint8_t> columns_[kRecordingColumns];  ///< Encode buffers, reused across chunks
+    uint64_t books_written_ = 0;                       ///< Books in the file
+    uint64_t bytes_written_ = 0;                       ///< File size
+};
+
+/**
+ * @brief Sequential reader of book recordings
+ *
+ * Decodes one chunk at a time; a chunk that is cut short or fails to
+ * decode ends the recording.
+ */
+class RecordingReader {
+public:
+    RecordingReader() = default;
+
+    RecordingReader(const RecordingReader&) = delete;
+    RecordingReader& operator=(const RecordingReader&) = delete;
+
+    /**
+     * @brief Opens a recording and reads its header
+     * @param path File to open
+     * @return false if the file is missing or not a recording of this version
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Reads the next book
+     * @param book Destination; exchange and pair index the recording's names
+     * @return false at the end of the recording
+     */
+    bool next(RecordedBook& book);
+
+    /// @brief Header of the recording
+    const RecordingHeader& header() const { return header_; }
+
+    /// @brief Name of exchange index i, from the header
+    std::string_view exchangeName(int i) const;
+
+    /// @brief Name of pair index i, from the header
+    std::string_view pairName(int i) const;
+
+private:
+    bool readChunk();
+
+    std::ifstream in_;                                 ///< Recording file
+    RecordingHeader header_{};                         ///< Header read by open()
+    std::vector<RecordedBook> books_;                  ///< Decoded books of the current chunk
+    size_t next_ = 0;                                  ///< Next book of books_ to return
+    std::vector<uint8_t> payload_;                     ///< Encoded columns of the current chunk
+};
+
+/**
+ * @brief Background recorder of every published book
+ *
+ * Feed handlers copy each book into a lock-free queue after publishing
+ * it; one thread drains the queue into a RecordingWriter. A full queue
+ * drops the book and counts it rather than stall the feed.
+ */
+class BookRecorder {
+public:
+    BookRecorder() = delete;  ///< Default constructor disabled
+
+    /**
+     * @brief Creates <dir>/books_<unix seconds>.l2rec
+     * @param dir Directory of the recording
+     * @throws std::runtime_error if the file cannot be created
+     */
+    explicit BookRecorder(const std::string& dir);
+
+    BookRecorder(const BookRecorder&) = delete;
+    BookRecorder& operator=(const BookRecorder&) = delete;
+
+    /**
+     * @brief Queues a book for recording (any thread, never blocks)
+     * @param exchange Index of the exchange in kExchanges
+     * @param pair Index of the pair in kPairs
+     * @param ob Book as published
+     */
+    void record(int exchange, int pair, const L2OrderBook& ob) {
+        ring_.tryPush(toRecordedBook(exchange, pair, ob));
+    }
+
+    /// @brief Writes queued books until stop() (recorder thread body)
+    void run();
+
+    /**
+     * @brief Ends the recording (any thread)
+     *
+     * run() writes every book queued before the call, flushes the open
+     * chunk and returns; join the recorder thread afterwards. Books
+     * recorded after the call are not written, so stop the feeds first.
+     */
+    void stop();
+
+    /// @brief Path of the recording
+    const std::string& path() const { return path_; }
+
+    /// @brief Books written to the file
+    uint64_t recorded() const { return recorded_.load(std::memory_order_relaxed); }
+
+    /// @brief Bytes written to the file
+    uint64_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+
+    /// @brief Books dropped because the queue was full
+    uint64_t dropped() const { return ring_.dropped(); }
+
+private:
+    /// @brief Exchange index of the queue entry stop() pushes
+    static constexpr uint8_t kStopExchange = 0xFF;
+
+    std::string path_;                                  ///< Recording file
+    RecordingWriter writer_;                            ///< Encoder, used by the recorder thread only
+    MpscRing<RecordedBook, kRecordingRingSize> ring_;   ///< Books from the feed handlers
+    std::atomic<uint64_t> recorded_{0};                 ///< Mirrors writer_.booksWritten() for metrics
+    std::atomic<uint64_t> bytes_{0};                    ///< Mirrors writer_.bytesWritten() for metrics
+    std::atomic<bool> finished_{false};                 ///< Set once run() has returned
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <simdjson.h>
+#include "book_parser.hpp"
+#include "orderbook.hpp"
+#include "recorder.hpp"
+#include "triangular.hpp"
+#include "utils.hpp"
+
+/// @brief Progress of a replay, shown with the metrics
+struct ReplayStats {
+    std::string source;                 ///< Recording or capture directory replayed, empty for live feeds
+    std::atomic<uint64_t> replayed{0};  ///< Books injected and detected
+    std::atomic<uint64_t> skipped{0};   ///< Books of disabled or unknown exchanges and pairs, or unreadable payloads
+    std::atomic<bool> done{false};      ///< Set once the last book has been detected
+    std::atomic<bool> stop{false};      ///< Set to end the replay after the book being injected
+};
+
+/**
+ * @brief Time-ordered source of replayed books
+ *
+ * Reads either a book recording (see BookRecorder) or a capture directory
+ * of raw payloads (see "capture_dir"). Recordings carry both timestamps of
+ * every book. Payloads are parsed with the live parsers and timed by their
+ * "timestamp" field, which is used as both handler and receive time; the
+ * files of a directory are merged in timestamp order.
+ */
+class ReplayFeed {
+public:
+    ReplayFeed() = default;
+
+    ReplayFeed(const ReplayFeed&) = delete;
+    ReplayFeed& operator=(const ReplayFeed&) = delete;
+
+    /**
+     * @brief Opens a recording or capture directory
+     * @param path .l2rec file, or directory of <exchange>_<BASE>-<QUOTE>.jsonl files
+     * @param cfg Configuration; only files of enabled exchanges and pairs
+     *            are read, and payloads are parsed at the configured scales
+     * @throws std::runtime_error if path is neither a readable recording
+     *         nor a directory holding a capture file
+     */
+    void open(const std::string& path, const config& cfg);
+
+    /**
+     * @brief Reads the next book
+     * @param exchange Set to the book's index in kExchanges
+     * @param pair Set to the book's index in kPairs
+     * @param ob Receives the raw levels, scale and timestamps; depth is left to ingestBook()
+     * @return false once every book has been read
+     */
+    bool next(int& exchange, int& pair, L2OrderBook& ob);
+
+    /// @brief Books skipped by the feed: unknown names or unreadable payloads
+    uint64_t skipped() const { return skipped_; }
+
+private:
+    /// @brief One capture file and its next parsed book
+    struct Capture {
+        int exchange;         ///< Index of the file's exchange
+        int pair;             ///< Index of the file's pair
+        BookParser parse;     ///< Live parser of the exchange
+        std::ifstream in;     ///< Capture file
+        L2OrderBook book;     ///< Next book of the file, valid while ready
+        bool ready = false;   ///< Whether book holds an unread message
+    };
+
+    bool readCapture(Capture& capture);
+
+    bool from_recording_ = false;                    ///< Whether the source is a recording
+    RecordingReader recording_;                      ///< Recording source
+    RecordedBook recorded_;                          ///< Decode buffer of the recording
+    int exchange_index_[kRecordingMaxNames];         ///< kExchanges index of each recorded exchange, -1 if unknown
+    int pair_index_[kRecordingMaxNames];             ///< kPairs index of each recorded pair, -1 if unknown
+    std::vector<std::unique_ptr<Capture>> captures_; ///< Capture sources, in (exchange, pair) order
+    simdjson::ondemand::parser parser_;              ///< Parser of the capture payloads
+    std::string line_;                               ///< Line buffer of the capture reader
+    uint64_t skipped_ = 0;                           ///< Books skipped by the feed
+};
+
+/**
+ * @brief Replays a feed through ingestBook() into the running detectors
+ *
+ * Drives the same path as the live feeds: each book gets its cumulative
+ * arrays, is published and queued to its pair's worker and to the cycle
+ * detector. Books are injected in lock-step: the next one is only
+ * published once every detector it was queued to has fully handled it, so
+ * no update is superseded and every run sees the same book sequence.
+ *
+ * DetectionClock is anchored on each book's recorded handler time as it
+ * is injected, so ages and latencies are measured in recorded time plus
+ * the real detection time, at any speed.
+ *
+ * @param feed Opened source of books
+ * @param cfg Configuration; replay.speed sets the pace (0 for as fast as possible)
+ * @param markets Books and queues of every pair, as given to process()
+ * @param cycles Queue and metrics of the cycle detector
+ * @param stats Progress, updated as books are replayed; stats.stop ends
+ *        the replay early
+ */
+void replayBooks(ReplayFeed& feed, const config& cfg, std::vector<PairBooks>& markets,
+                 CycleEngine& cycles, ReplayStats& stats);
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <sys/uio.h>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+
+/// @brief Maximum number of buffers gathered into one recvmsg call
+const int kMaxRxIov = 8;
+
+/**
+ * @brief TCP socket that records the kernel receive timestamp of every read
+ *
+ * Used as the next layer of the TLS stream, so the timestamp is taken on the
+ * encrypted bytes as they leave the socket queue, before TLS decryption,
+ * websocket framing and JSON parsing.
+ *
+ * Reads go through recvmsg() with SO_TIMESTAMPING (or SO_TIMESTAMPNS on
+ * kernels without it) so the timestamp arrives as a control message.
+ * Hardware timestamps are used when requested and delivered by the NIC;
+ * otherwise the kernel's software timestamp is used. If the kernel
+ * delivers neither, the read time itself is recorded.
+ *
+ * The timestamp kept is that of the latest read, i.e. when the last bytes
+ * of the message being handled reached the host.
+ */
+class RxTimestampSocket : public boost::asio::ip::tcp::socket {
+public:
+    using boost::asio::ip::tcp::socket::basic_stream_socket;
+
+    /**
+     * @brief Prefers NIC hardware timestamps over software ones
+     * @note Hardware timestamps are in the NIC clock domain; they are only
+     *       comparable to system time when the NIC clock is synchronized
+     *       to it (e.g. with phc2sys)
+     */
+    void setHardwareTimestamps(bool hardware) { hardware_ = hardware; }
+
+    /// @brief Receive timestamp of the latest read
+    std::chrono::high_resolution_clock::time_point lastRxTime() const { return rx_time_; }
+
+    /**
+     * @brief Asynchronous read that captures the receive timestamp
+     *
+     * Waits for readability, then reads with a non-blocking recvmsg(). Hides
+     * tcp::socket::async_read_some so the TLS stream and websocketpp use it
+     * unchanged.
+     *
+     * The internal completions are bound to the handler's associated
+     * executor, so a handler bound to a strand still completes on that
+     * strand, whatever number of threads runs the io_service.
+     */
+    template <typename MutableBufferSequence, typename ReadHandler>
+    void async_read_some(const MutableBufferSequence& buffers, ReadHandler&& handler) {
+        auto executor = boost::asio::get_associated_executor(handler, get_executor());
+        if (boost::asio::buffer_size(buffers) == 0) {
+            // Zero-byte reads complete immediately, as on a plain socket
+            auto complete = [h = std::forward<ReadHandler>(handler)]() mutable {
+                h(boost::system::error_code(), 0);
+            };
+            boost::asio::post(boost::asio::bind_executor(executor, std::move(complete)));
+            return;
+        }
+        auto on_readable = [this, buffers, h = std::forward<ReadHandler>(handler)](
+                               boost::system::error_code ec) mutable {
+            // On error the socket may already be gone, so do not touch this
+            if (ec) {
+                h(ec, 0);
+                return;
+            }
+            iovec iov[kMaxRxIov];
+            int count = 0;
+            for (auto it = boost::asio::buffer_sequence_begin(buffers);
+                 it != boost::asio::buffer_sequence_end(buffers) && count < kMaxRxIov; ++it) {
+                boost::asio::mutable_buffer b(*it);
+                iov[count++] = {b.data(), b.size()};
+            }
+            bool would_block = false;
+            size_t n = receive(iov, count, ec, would_block);
+            if (would_block) {
+                async_read_some(buffers, std::move(h));
+                return;
+            }
+            h(ec, n);
+        };
+        async_wait(wait_read, boost::asio::bind_executor(executor, std::move(on_readable)));
+    }
+
+private:
+    /**
+     * @brief Non-blocking recvmsg() that updates rx_time_
+     * @param iov Destination buffers
+     * @param count Number of entries in iov
+     * @param ec Set on error or end of stream
+     * @param would_block Set if no data was available after all
+     * @return Number of bytes read
+     */
+    size_t receive(iovec* iov, int count, boost::system::error_code& ec, bool& would_block);
+
+    /// @brief Turns on receive timestamping; done on the first read, once connected
+    void enableTimestamps();
+
+    bool hardware_ = false;  ///< Prefer hardware timestamps
+    bool enabled_ = false;   ///< Whether timestamping was requested from the kernel
+    std::chrono::high_resolution_clock::time_point rx_time_;  ///< Receive time of the latest read
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief Single-writer sequence lock for publishing trivially copyable state
+ *
+ * The writer never blocks: it bumps the sequence to an odd value, copies the
+ * new state in, and bumps it back to even. Readers copy the state out and
+ * retry only if the sequence was odd or changed while they were copying, so a
+ * torn snapshot is never returned.
+ *
+ * The sequence doubles as a version number: every successful publish advances
+ * it by 2, which lets readers detect new data without a separate flag.
+ *
+ * @tparam T Trivially copyable payload type
+ */
+template <typename T>
+class alignas(64) SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock payload must be trivially copyable");
+
+public:
+    /**
+     * @brief Publishes a new value (single writer only)
+     * @param value State to publish
+     * @return Version number of the published state
+     */
+    uint64_t publish(const T& value) {
+        uint64_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&data_, &value, sizeof(T));
+        seq_.store(seq + 2, std::memory_order_release);
+        return seq + 2;
+    }
+
+    /**
+     * @brief Copies out a consistent snapshot, retrying on writer collision
+     * @param out Destination for the snapshot
+     * @return Version number of the snapshot that was read
+     */
+    uint64_t read(T& out) const {
+        while (true) {
+            uint64_t before = seq_.load(std::memory_order_acquire);
+            if (before & 1)
+                continue;
+            std::memcpy(&out, &data_, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == before)
+                return before;
+        }
+    }
+
+    /**
+     * @brief Current version without reading the payload
+     * @return Latest published version (odd while a write is in progress)
+     */
+    uint64_t version() const { return seq_.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<uint64_t> seq_{0};  ///< Even when stable, odd while writing
+    T data_{};                      ///< Published state
+};
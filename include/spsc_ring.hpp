@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Bounded lock-free single-producer single-consumer ring buffer
+ *
+ * Storage is allocated with the ring, so pushing never allocates. Each side
+ * owns one index and keeps a cached copy of the other's, so a push or pop
+ * only touches the shared indices when its cached view says the ring is
+ * full or empty. When the ring is full the push fails and is counted
+ * instead of blocking the producer.
+ *
+ * The ring does not wake its consumer; owners that multiplex several rings
+ * signal the consumer themselves (see OpportunitySink).
+ *
+ * @tparam T Element type (copied in and out)
+ * @tparam Capacity Number of slots, must be a power of two
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscRing() = default;
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /**
+     * @brief Enqueues an element without blocking (producer thread only)
+     * @param value Element to enqueue
+     * @return false if the ring was full and the element was dropped
+     */
+    bool tryPush(const T& value) {
+        if (tail_ - head_cache_ == Capacity) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail_ - head_cache_ == Capacity) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        slots_[tail_ & kMask] = value;
+        ++tail_;
+        published_tail_.store(tail_, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Dequeues an element if one is ready (consumer thread only)
+     * @param out Destination for the element
+     * @return false if the ring was empty
+     */
+    bool tryPop(T& out) {
+        if (head_local_ == tail_cache_) {
+            tail_cache_ = published_tail_.load(std::memory_order_acquire);
+            if (head_local_ == tail_cache_)
+                return false;
+        }
+        out = slots_[head_local_ & kMask];
+        ++head_local_;
+        head_.store(head_local_, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief Number of pushes rejected because the ring was full
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint64_t kMask = Capacity - 1;
+
+    T slots_[Capacity];                                  ///< Ring storage
+    alignas(64) std::atomic<uint64_t> published_tail_{0}; ///< Next position written, as seen by the consumer
+    std::atomic<uint64_t> dropped_{0};                   ///< Pushes rejected on overflow
+    uint64_t tail_{0};                                   ///< Next position written (producer)
+    uint64_t head_cache_{0};                             ///< Producer's copy of head_
+    alignas(64) std::atomic<uint64_t> head_{0};          ///< Next position read, as seen by the producer
+    uint64_t head_local_{0};                             ///< Next position read (consumer)
+    uint64_t tail_cache_{0};                             ///< Consumer's copy of published_tail_
+};
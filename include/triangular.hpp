@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+#include "orderbook.hpp"
+#include "utils.hpp"
+
+/// @brief One leg of a cycle: a book and the direction it is traded in
+struct CycleLeg {
+    int exchange;   ///< Index of the exchange in kExchanges
+    int pair;       ///< Index of the trading pair in kPairs
+    bool buy_base;  ///< Spend the quote for the base on the asks, else sell the base on the bids
+};
+
+/**
+ * @brief Precomputed 3-leg currency cycle
+ *
+ * The output currency of each leg is the input currency of the next, and
+ * the last leg returns the input currency of the first (the start
+ * currency). Legs may trade on one exchange or on several.
+ */
+struct Cycle {
+    CycleLeg legs[kCycleLegs];  ///< Legs in trading order
+};
+
+/// @brief Event queue and metrics of the triangular cycle detector
+struct CycleEngine {
+    BookEventQueue events;  ///< Updates of every book that is a leg of some cycle
+    Metrics metrics;        ///< Updates processed, cycles found and cycles pruned
+};
+
+/// @brief Currency a leg spends
+inline std::string_view legInput(int pair, bool buy_base) {
+    return buy_base ? pairQuote(pair) : pairBase(pair);
+}
+
+/// @brief Currency a leg receives
+inline std::string_view legOutput(int pair, bool buy_base) {
+    return buy_base ? pairBase(pair) : pairQuote(pair);
+}
+
+/**
+ * @brief Enumerates every 3-leg cycle over the enabled pairs and exchanges
+ *
+ * Builds the currency graph of the enabled pairs (one edge per pair) and
+ * finds all of its triangles. Each triangle yields two cycles, one per
+ * direction, for every assignment of enabled exchanges to its legs. A
+ * cycle starts in the currency that quotes the most enabled pairs (USDT
+ * for the built-in pairs), so its profit is reported in that currency.
+ *
+ * @param cfg Trading configuration
+ * @return All cycles, empty if the enabled pairs form no triangle
+ */
+std::vector<Cycle> buildCycles(const config& cfg);
+
+/**
+ * @brief Finds the start amount that maximizes the profit of a cycle
+ *
+ * Each leg is a concave piecewise-linear conversion over its book's
+ * cumulative arrays (so each leg is capped at max_order_size of its pair's
+ * base), and their composition is concave too. The search walks all three
+ * books at once like solveBestSize(): the marginal rate of the cycle is the
+ * product of the legs' current level rates after fees, and the walk stops
+ * at the first level boundary where it no longer exceeds 1. Cost is
+ * O(levels) per cycle.
+ *
+ * @param cycle Cycle to evaluate
+ * @param books Book of each leg, with cumulative arrays built
+ * @param fees Fee of each exchange from feeUnits(), indexed by exchange
+ * @param min_profit Minimum net profit, in the start currency
+ * @param best Filled with the legs, levels, amounts and profit of the optimum;
+ *        timing is left to the caller
+ * @return true if the optimal amount clears min_profit
+ */
+bool evaluateCycle(const Cycle& cycle, const L2OrderBook* const books[kCycleLegs],
+                   const int64_t* fees, double min_profit, CycleOpportunity& best);
+
+/**
+ * @brief Triangular cycle detection thread
+ *
+ * Pops the events of every book that is a leg of some cycle and
+ * re-evaluates only the cycles through the updated book: at most
+ * 2 * E^2 cycles per triangle the pair belongs to, each in O(levels).
+ * Runs beside the pair workers on its own queue and reads books through
+ * the same seqlocks, so it never delays them; it blocks while idle and
+ * keeps the default scheduler, even in busy-poll mode.
+ *
+ * @param markets Books of every pair, indexed by pair
+ * @param engine Event queue fed by the cycle legs' feeds, and metrics
+ * @param cycles Cycles from buildCycles()
+ * @param cfg Trading configuration parameters
+ * @param sink Destination of the triangular opportunities
+ * @note Returns on the event queued by queueStop()
+ */
+void cycleProcess(std::vector<PairBooks>& markets, CycleEngine& engine,
+                  const std::vector<Cycle>& cycles, config& cfg, OpportunitySink& sink);
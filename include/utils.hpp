@@ -1,6 +1,7 @@
 #pragma once
 
-#include <semaphore>
+#include <cmath>
+#include <cstdint>
 #include <string_view>
 #include <array>
 #include <string>
@@ -10,7 +11,7 @@
 const int kTotalExchanges = 3;
 
 /// @brief Total number of supported trading pairs
-const int kTotalPairs = 3;
+const int kTotalPairs = 4;
 
 /// @brief Array of supported exchange names
 /// @note Order must match the exchange indices used throughout the code
@@ -18,7 +19,18 @@ constexpr std::array<std::string_view, kTotalExchanges> kExchanges = {"okx", "de
 
 /// @brief Array of supported trading pairs
 /// @note Format is BASE/QUOTE (e.g., BTC/USDT)
-constexpr std::array<std::string_view, kTotalPairs> kPairs = {"BTC/USDT", "ETH/USDT", "SOL/USDT"};
+/// @note ETH/BTC closes the USDT-BTC-ETH triangle used by the cycle detector
+constexpr std::array<std::string_view, kTotalPairs> kPairs = {"BTC/USDT", "ETH/USDT", "SOL/USDT", "ETH/BTC"};
+
+/// @brief Base currency of a trading pair, e.g. "BTC" for BTC/USDT
+inline std::string_view pairBase(int pair) {
+    return kPairs[pair].substr(0, kPairs[pair].find('/'));
+}
+
+/// @brief Quote currency of a trading pair, e.g. "USDT" for BTC/USDT
+inline std::string_view pairQuote(int pair) {
+    return kPairs[pair].substr(kPairs[pair].find('/') + 1);
+}
 
 /// @brief Base websocket hostnames for each exchange
 /// @note Order must match kExchanges array
@@ -28,13 +40,100 @@ constexpr std::array<std::string_view, kTotalExchanges> kHostNames = {
     "ws.gomarket-cpp.goquant.io/ws/l2-orderbook/bybit/"
 };
 
-/// @brief Flag indicating whether each exchange uses string representation for doubles
-/// @note Required for proper JSON parsing of numeric values
-constexpr std::array<bool, kTotalExchanges> kUseDoubleInString = {true, false, true};
+/// @brief Powers of ten used to convert between decimals and fixed-point units
+constexpr std::array<int64_t, 19> kPow10 = {
+    1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL,
+    100000000LL, 1000000000LL, 10000000000LL, 100000000000LL,
+    1000000000000LL, 10000000000000LL, 100000000000000LL,
+    1000000000000000LL, 10000000000000000LL, 100000000000000000LL,
+    1000000000000000000LL
+};
 
-/// @brief Path to store detected arbitrage opportunities
-/// @note File is opened in append mode
-const std::string kOppStoragePath = "../storage/opportunities.txt";
+/**
+ * @brief Converts a decimal value to fixed-point units, rounding to nearest
+ * @param value Value to convert
+ * @param decimals Number of decimal places kept
+ * @return value * 10^decimals, rounded
+ */
+inline int64_t toFixed(double value, int decimals) {
+    return std::llround(value * static_cast<double>(kPow10[decimals]));
+}
+
+/**
+ * @brief Fixed-point scale of one instrument
+ *
+ * Prices are stored as integer ticks of 10^-price_decimals and quantities
+ * as integer lots of 10^-qty_decimals. The product of the largest order in
+ * lots and the largest price in ticks must fit in int64.
+ */
+struct Scale {
+    int price_decimals;  ///< Decimal places kept for prices
+    int qty_decimals;    ///< Decimal places kept for quantities
+};
+
+/// @brief Scale of USDT-quoted pairs without a "scales" entry in config.json
+constexpr Scale kDefaultScale = {2, 6};
+
+/// @brief Scale of each pair without a "scales" entry in config.json
+/// @note Order must match kPairs; ETH/BTC trades around 0.03, so it keeps 8 price decimals
+constexpr std::array<Scale, kTotalPairs> kDefaultScales = {kDefaultScale, kDefaultScale, kDefaultScale, Scale{8, 6}};
+
+/// @brief Maximum number of websocket I/O threads (one per connection)
+const int kMaxIoThreads = kTotalExchanges * kTotalPairs;
+
+/// @brief Upper bound on the helper threads of one detection pool
+const int kMaxDetectThreads = 64;
+
+/// @brief Default smallest batch of exchange pairs detected in parallel
+const int kDefaultDetectMinPairs = 16;
+
+/**
+ * @brief Thread placement and waiting policy for latency-critical deployments
+ *
+ * Every field defaults to "off", which leaves scheduling to the OS and
+ * makes idle threads sleep.
+ */
+struct LowLatency {
+    bool busy_poll;                ///< Spin with pause hints instead of sleeping while idle
+    int rt_priority;               ///< SCHED_FIFO priority of I/O, process and pinned detection threads, 0 to disable
+    int process_cores[kTotalPairs];  ///< Cores of the per-pair process threads, in pair order
+    int process_core_count;        ///< Number of entries in process_cores (0 leaves them unpinned)
+    int db_core;                   ///< Core of the database writer and recorder threads, -1 to leave unpinned
+    int io_cores[kMaxIoThreads];   ///< Cores of the I/O threads, assigned round-robin
+    int io_core_count;             ///< Number of entries in io_cores (0 leaves them unpinned)
+    int detect_cores[kTotalPairs * kMaxDetectThreads];  ///< Cores of the detection pool helpers, assigned round-robin
+    int detect_core_count;         ///< Number of entries in detect_cores (0 leaves helpers unpinned and sleeping)
+};
+
+/// @brief SQLite synchronous levels, in PRAGMA synchronous order
+const std::array<std::string_view, 4> kDbSynchronousLevels = {"off", "normal", "full", "extra"};
+
+/**
+ * @brief Batching and durability of the database writer
+ *
+ * Summaries are inserted into one open transaction, committed once it
+ * holds batch_rows rows or has been open batch_ms, whichever comes first.
+ * The database runs in WAL mode, where synchronous "normal" only syncs on
+ * checkpoints: a power loss can drop the last commits but never corrupts
+ * the file.
+ */
+struct DbSettings {
+    int synchronous;   ///< Index in kDbSynchronousLevels
+    int batch_rows;    ///< Rows that force a commit
+    double batch_ms;   ///< Longest time a row waits for its commit
+};
+
+/**
+ * @brief Offline replay of recorded books in place of the live feeds
+ *
+ * Books are injected one at a time and each is fully detected before the
+ * next, so a replay finds the same opportunities on every run.
+ */
+struct ReplaySettings {
+    std::string path;      ///< Recording (.l2rec) or capture directory, empty for live feeds
+    double speed;          ///< Multiple of the recorded pace, 0 for as fast as possible
+    bool exit_when_done;   ///< Exit once every book has been replayed
+};
 
 /// @brief Path to SQLite database for orderbook summaries
 /// @note Database is created if it doesn't exist
@@ -51,8 +150,21 @@ struct config {
     double min_profit;        ///< Minimum profit threshold for trades (in USD)
     double max_order_size;    ///< Maximum allowed order size (in base currency)
     double latency_ms;        ///< Expected latency in milliseconds
+    double max_book_age_ms[kTotalExchanges];  ///< Age beyond which a venue's book is not traded against, 0 for no limit
     bool exchanges[kTotalExchanges];  ///< Active exchanges flags
     bool pairs[kTotalPairs];         ///< Active trading pairs flags
+    bool incremental;                ///< Only re-evaluate exchange pairs touching the updated book
+    bool triangular;                 ///< Run the triangular cycle detector alongside the pair workers
+    int detect_threads;              ///< Helper threads of each pair worker's detection pool, 0 for serial detection
+    int detect_min_pairs;            ///< Fewest exchange pairs in an update that are detected in parallel
+    int io_threads;                  ///< Event loop threads shared by all websocket connections
+    LowLatency low_latency;          ///< Core pinning, real-time scheduling and busy-poll settings
+    DbSettings db;                   ///< Commit batching and synchronous level of the database writer
+    bool hw_timestamps;              ///< Prefer NIC hardware receive timestamps over kernel software ones
+    std::string capture_dir;         ///< Directory raw payloads are appended to, empty to disable
+    std::string record_dir;          ///< Directory of the full-depth book recording, empty to disable
+    ReplaySettings replay;           ///< Replay source and pace, replaces the live feeds when set
+    Scale scales[kTotalPairs];       ///< Fixed-point scale of each trading pair
 };
 
 /**
@@ -60,9 +172,22 @@ struct config {
  * 
  * Validates and loads trading configuration including:
  * - Enabled exchanges and their fees
- * - Trading pairs (currently limited to one pair)
+ * - Trading pairs, each detected on its own worker thread
  * - Profit thresholds and order size limits
  * - Expected latency parameters
+ * - Optional detection mode ("incremental", defaults to true)
+ * - Optional number of websocket I/O threads ("io_threads", defaults to 1)
+ * - Optional low-latency thread settings ("low_latency", defaults to off)
+ * - Optional hardware receive timestamps ("hw_timestamps", defaults to false)
+ * - Optional payload capture directory ("capture_dir", defaults to none)
+ * - Optional book recording directory ("record_dir", defaults to none)
+ * - Optional offline replay ("replay", defaults to live feeds)
+ * - Optional per-venue book age limits ("max_book_age_ms", no limit by default)
+ * - Optional triangular cycle detection ("triangular", defaults to false)
+ * - Optional parallel detection ("parallel_detection", defaults to serial)
+ * - Optional database writer settings ("db", defaults to normal sync,
+ *   1000 rows or 100 ms per commit)
+ * - Optional fixed-point scales per pair ("scales", defaults to kDefaultScales)
  * 
  * @param file_path Path to the configuration JSON file
  * @param config Reference to the config structure to populate
@@ -84,9 +209,3 @@ void loadConfig(const std::string& file_path, config& config, simdjson::ondemand
  */
 int getIndex(std::string_view name, int type);
 
-/// @brief Semaphore for synchronizing orderbook updates
-extern std::counting_semaphore<kTotalExchanges> sem;
-
-/// @brief Semaphore for synchronizing database writes
-extern std::counting_semaphore<kTotalExchanges> sem1;
-
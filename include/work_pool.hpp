@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <pthread.h>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Small fork-join pool with range stealing, for per-update parallel loops
+ *
+ * parallelFor() splits an index range evenly across the calling thread and
+ * the pool's helper threads. Each participant takes indices from the front
+ * of its own range; one that runs dry steals the back half of another
+ * participant's remaining range, so uneven item costs are rebalanced
+ * without a shared queue. A range is one 64-bit word (loop tag, begin,
+ * end) updated by CAS, which makes taking and stealing lock-free.
+ *
+ * The caller works on the loop itself and returns as soon as every index
+ * has run; it does not wait for helpers that were still asleep, and the
+ * loop tag keeps such late helpers from claiming indices of a later loop.
+ * Only one thread may call parallelFor() at a time.
+ *
+ * Idle helpers sleep on the loop counter, or spin on it with pause hints
+ * in busy-poll mode.
+ */
+class WorkStealingPool {
+public:
+    /// @brief Largest index count of one loop (24-bit range bounds)
+    static constexpr int kMaxIndices = 1 << 24;
+
+    WorkStealingPool() = delete;  ///< Default constructor disabled
+
+    /**
+     * @brief Starts the helper threads
+     * @param helpers Threads in addition to the caller of parallelFor(), 0 for none
+     * @param busy_poll Spin instead of sleeping while waiting for a loop
+     */
+    explicit WorkStealingPool(int helpers, bool busy_poll = false);
+
+    /// @brief Stops and joins the helper threads
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /// @brief Number of participants in a loop: the caller plus the helpers
+    int size() const { return static_cast<int>(helpers_.size()) + 1; }
+
+    /// @brief Native handle of helper thread i, for pinning
+    pthread_t nativeHandle(int i) { return helpers_[i].native_handle(); }
+
+    /**
+     * @brief Runs fn(index, worker) for every index in [0, count)
+     *
+     * worker is the participant running the call, 0 for the calling thread
+     * and 1..size()-1 for helpers; callers use it to keep per-participant
+     * outputs without locking. Returns when every index has run.
+     *
+     * @param count Number of indices, at most kMaxIndices
+     * @param fn Callable taking (int index, int worker)
+     */
+    template <typename Fn>
+    void parallelFor(int count, Fn&& fn) {
+        run(count, [](void* ctx, int index, int worker) { (*static_cast<Fn*>(ctx))(index, worker); },
+            &fn);
+    }
+
+private:
+    using Task = void (*)(void* ctx, int index, int worker);
+
+    /// @brief Remaining [begin, end) of one participant and its loop tag, packed into one word
+    struct alignas(64) Range {
+        std::atomic<uint64_t> bounds{0};
+    };
+
+    void run(int count, Task task, void* ctx);
+    void helperLoop(int worker);
+    void participate(int worker);
+    bool takeOwn(int worker, uint64_t tag, int& index);
+    bool steal(int worker, uint64_t tag);
+
+    static constexpr uint64_t kBoundMask = (uint64_t(1) << 24) - 1;
+
+    static uint64_t pack(uint64_t tag, uint64_t begin, uint64_t end) { return (tag << 48) | (begin << 24) | end; }
+    static uint64_t tagOf(uint64_t bounds) { return bounds >> 48; }
+    static uint64_t beginOf(uint64_t bounds) { return (bounds >> 24) & kBoundMask; }
+    static uint64_t endOf(uint64_t bounds) { return bounds & kBoundMask; }
+
+    std::vector<std::thread> helpers_;        ///< Helper threads, workers 1..size()-1
+    std::unique_ptr<Range[]> ranges_;         ///< Remaining range of each participant
+    Task task_ = nullptr;                     ///< Callback of the current loop
+    void* ctx_ = nullptr;                     ///< Context of the current loop
+    bool busy_poll_;                          ///< Spin instead of sleeping between loops
+    alignas(64) std::atomic<uint64_t> epoch_{0};  ///< Loops started, watched by idle helpers
+    alignas(64) std::atomic<int> pending_{0};     ///< Indices of the current loop not yet run
+    std::atomic<bool> stop_{false};               ///< Set to make helpers exit
+};
@@ -1,13 +1,18 @@
 #pragma once
 
+#include <fstream>
 #include <websocketpp/client.hpp>
 #include <websocketpp/common/thread.hpp>
 #include <websocketpp/config/asio_client.hpp>
 #include <simdjson.h>
+#include "book_parser.hpp"
+#include "io_pool.hpp"
+#include "ws_config.hpp"
 #include "orderbook.hpp"
+#include "recorder.hpp"
 #include "utils.hpp"
 
-using client = websocketpp::client<websocketpp::config::asio_tls_client>;
+using client = websocketpp::client<ArbClientConfig>;
 using context_ptr = websocketpp::lib::shared_ptr<boost::asio::ssl::context>;
 
 /**
@@ -24,11 +29,23 @@ public:
     /**
      * @brief Constructs a WebSocket client
      * @param hostname The WebSocket server hostname
-     * @param double_in_string Whether numbers are received as strings
-     * @param orderbook Reference to the orderbook to update
+     * @param exchange Index of the exchange in kExchanges
+     * @param pair Index of the trading pair in kPairs
+     * @param scale Fixed-point scale prices and quantities are converted to
+     * @param max_order_size Order size limit used to build the book's cumulative arrays
+     * @param orderbook Publication slot of this (exchange, pair) book
+     * @param events Event queue of the pair's detection worker
+     * @param cycle_events Event queue of the cycle detector, nullptr if the pair is not a cycle leg
+     * @param io Shared event loop the connection's handlers run on
+     * @param hw_timestamps Prefer NIC hardware receive timestamps over kernel software ones
+     * @param capture_dir Directory to append raw payloads to (one per line), empty to disable
+     * @param recorder Recorder every published book is queued to, nullptr to disable
      * @throws std::runtime_error if connection fails
      */
-    wsClient(std::string hostname, bool double_in_string, L2OrderBook& orderbook);
+    wsClient(std::string hostname, int exchange, int pair, Scale scale,
+             double max_order_size, PublishedBook& orderbook, BookEventQueue& events,
+             BookEventQueue* cycle_events, IoService& io, bool hw_timestamps, const std::string& capture_dir,
+             BookRecorder* recorder);
     
     /**
      * @brief Destructor - ensures proper cleanup of WebSocket connection
@@ -50,6 +67,13 @@ private:
      */
     context_ptr onTLSInit(websocketpp::connection_hdl hdl);
 
+    /**
+     * @brief Socket creation callback, before the connection is made
+     * @param hdl Connection handle
+     * @param stream TLS stream whose TCP layer records receive timestamps
+     */
+    void onSocketInit(websocketpp::connection_hdl hdl, rx_tls_socket::stream_type& stream);
+
     /**
      * @brief Connection open callback
      * @param c Client pointer
@@ -82,20 +106,35 @@ private:
     std::string status_;                 ///< Current connection status
     std::string err_reason_;             ///< Error message if connection failed
     std::string uri_;                    ///< WebSocket URI
-    bool double_in_string_;              ///< Whether numbers are received as strings
-    std::shared_ptr<std::thread> thread_; ///< WebSocket client thread
+    int exchange_;                       ///< Exchange index reported in book events
+    int pair_;                           ///< Pair index reported in book events
+    BookParser parse_;                   ///< Parser specialized for the exchange schema
+    Scale scale_;                        ///< Fixed-point scale of the pair
+    Lots max_lots_;                      ///< Order size cap in lots, for cumulative arrays
+    bool overflow_warned_ = false;       ///< Whether a notional overflow was reported
+    bool hw_timestamps_;                 ///< Prefer hardware receive timestamps
+    RxTimestampSocket* rx_socket_ = nullptr;  ///< TCP layer of the live connection, for receive timestamps
+    std::ofstream capture_;              ///< Raw payload capture for arb_parse_bench, if enabled
     websocketpp::connection_hdl hdl_;    ///< Connection handle
     simdjson::ondemand::parser parser_;  ///< JSON parser
-    L2OrderBook& snapshot_;              ///< Reference to orderbook to update
+    L2OrderBook snapshot_;               ///< Private parse target, published when complete
+    PublishedBook& book_;                ///< Publication slot shared with process()
+    BookEventQueue& events_;             ///< Update events of the pair, consumed by its process()
+    BookEventQueue* cycle_events_;       ///< Update events for cycleProcess(), if the pair is a cycle leg
+    BookRecorder* recorder_;             ///< Full-depth recorder, if enabled
 };
 
 /**
  * @brief Connects to all configured exchange endpoints
  * @param config Trading configuration
  * @param clients Vector to store created WebSocket clients
- * @param orderbooks Vector of orderbooks for each exchange
+ * @param markets Books and event queues of each pair, indexed by pair
+ * @param io_pool Event loops the connections are multiplexed over
+ * @param recorder Recorder every published book is queued to, nullptr to disable
  * @throws std::runtime_error if connection to any endpoint fails
  */
 void connectToEndpoints(const config& config, 
                        std::vector<std::unique_ptr<wsClient>>& clients,
-                       std::vector<L2OrderBook>& orderbooks);
+                       std::vector<PairBooks>& markets,
+                       IoPool& io_pool,
+                       BookRecorder* recorder);
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+#include <websocketpp/config/asio_client.hpp>
+#include <websocketpp/message_buffer/alloc.hpp>
+#include <websocketpp/message_buffer/message.hpp>
+#include <websocketpp/transport/asio/endpoint.hpp>
+#include <websocketpp/transport/asio/security/base.hpp>
+#include <websocketpp/uri.hpp>
+#include "msg_pool.hpp"
+#include "rx_socket.hpp"
+
+/**
+ * @brief websocketpp TLS socket policy running TLS over RxTimestampSocket
+ *
+ * Same behaviour as websocketpp::transport::asio::tls_socket (SNI, handshake
+ * on the connection strand, TLS error translation); the only difference is
+ * the TCP layer under the TLS stream, which records kernel receive
+ * timestamps. websocketpp hard-codes tcp::socket in its own policy, hence
+ * the separate policy.
+ */
+namespace rx_tls_socket {
+
+namespace ws = websocketpp;
+namespace ws_socket = websocketpp::transport::asio::socket;
+namespace asio = websocketpp::lib::asio;
+
+/// @brief TLS stream over the timestamping TCP socket
+using stream_type = asio::ssl::stream<RxTimestampSocket>;
+
+/// @brief Called when a connection's socket is created, before it connects
+using socket_init_handler = ws::lib::function<void(ws::connection_hdl, stream_type&)>;
+
+/// @brief Called to obtain the TLS context of a new connection
+using tls_init_handler = ws::lib::function<ws::lib::shared_ptr<asio::ssl::context>(ws::connection_hdl)>;
+
+/// @brief Per-connection socket component
+class connection : public ws::lib::enable_shared_from_this<connection> {
+public:
+    typedef connection type;
+    typedef ws::lib::shared_ptr<type> ptr;
+    typedef stream_type socket_type;
+    typedef ws::lib::shared_ptr<socket_type> socket_ptr;
+    typedef asio::io_service* io_service_ptr;
+    typedef ws::lib::shared_ptr<asio::io_service::strand> strand_ptr;
+    typedef ws::lib::shared_ptr<asio::ssl::context> context_ptr;
+
+    explicit connection() {}
+
+    ptr get_shared() { return shared_from_this(); }
+
+    bool is_secure() const { return true; }
+
+    socket_type::lowest_layer_type& get_raw_socket() { return m_socket->lowest_layer(); }
+
+    socket_type::next_layer_type& get_next_layer() { return m_socket->next_layer(); }
+
+    socket_type& get_socket() { return *m_socket; }
+
+    void set_socket_init_handler(socket_init_handler h) { m_socket_init_handler = h; }
+
+    void set_tls_init_handler(tls_init_handler h) { m_tls_init_handler = h; }
+
+    std::string get_remote_endpoint(ws::lib::error_code& ec) const {
+        std::stringstream s;
+        ws::lib::asio::error_code aec;
+        asio::ip::tcp::endpoint ep = m_socket->lowest_layer().remote_endpoint(aec);
+        if (aec) {
+            ec = ws_socket::make_error_code(ws_socket::error::pass_through);
+            s << "Error getting remote endpoint: " << aec << " (" << aec.message() << ")";
+        } else {
+            ec = ws::lib::error_code();
+            s << ep;
+        }
+        return s.str();
+    }
+
+    /// @brief Maps asio/TLS errors to websocketpp transport errors
+    template <typename ErrorCodeType>
+    static ws::lib::error_code translate_ec(ErrorCodeType ec) {
+        if (ec.category() == asio::error::get_ssl_category())
+            return ws::transport::error::make_error_code(ws::transport::error::tls_error);
+        return ws::transport::error::make_error_code(ws::transport::error::pass_through);
+    }
+
+    /// @brief Overload for when lib::error_code is the asio error code type
+    static ws::lib::error_code translate_ec(ws::lib::error_code ec) { return ec; }
+
+protected:
+    ws::lib::error_code init_asio(io_service_ptr service, strand_ptr strand, bool is_server) {
+        if (!m_tls_init_handler)
+            return ws_socket::make_error_code(ws_socket::error::missing_tls_init_handler);
+        m_context = m_tls_init_handler(m_hdl);
+        if (!m_context)
+            return ws_socket::make_error_code(ws_socket::error::invalid_tls_context);
+
+        m_socket = ws::lib::make_shared<socket_type>(*service, *m_context);
+        if (m_socket_init_handler)
+            m_socket_init_handler(m_hdl, get_socket());
+
+        m_io_service = service;
+        m_strand = strand;
+        m_is_server = is_server;
+        return ws::lib::error_code();
+    }
+
+    void set_uri(ws::uri_ptr u) { m_uri = u; }
+
+    void pre_init(ws::transport::init_handler callback) {
+        // Server Name Indication, needed by hosts serving several certificates
+        if (!m_is_server) {
+            std::string const& host = m_uri->get_host();
+            ws::lib::asio::error_code ec_addr;
+            asio::ip::make_address(host, ec_addr);
+            if (ec_addr && SSL_set_tlsext_host_name(get_socket().native_handle(), host.c_str()) != 1) {
+                callback(ws_socket::make_error_code(ws_socket::error::tls_failed_sni_hostname));
+                return;
+            }
+        }
+        callback(ws::lib::error_code());
+    }
+
+    void post_init(ws::transport::init_handler callback) {
+        m_ec = ws_socket::make_error_code(ws_socket::error::tls_handshake_timeout);
+        auto handler = ws::lib::bind(&type::handle_init, get_shared(), callback,
+                                     ws::lib::placeholders::_1);
+        if (m_strand)
+            m_socket->async_handshake(get_handshake_type(), m_strand->wrap(handler));
+        else
+            m_socket->async_handshake(get_handshake_type(), handler);
+    }
+
+    void set_handle(ws::connection_hdl hdl) { m_hdl = hdl; }
+
+    void handle_init(ws::transport::init_handler callback, ws::lib::asio::error_code const& ec) {
+        if (ec)
+            m_ec = ws_socket::make_error_code(ws_socket::error::tls_handshake_failed);
+        else
+            m_ec = ws::lib::error_code();
+        callback(m_ec);
+    }
+
+    ws::lib::error_code get_ec() const { return m_ec; }
+
+    ws::lib::asio::error_code cancel_socket() {
+        ws::lib::asio::error_code ec;
+        get_raw_socket().cancel(ec);
+        return ec;
+    }
+
+    void async_shutdown(ws_socket::shutdown_handler callback) {
+        if (m_strand)
+            m_socket->async_shutdown(m_strand->wrap(callback));
+        else
+            m_socket->async_shutdown(callback);
+    }
+
+private:
+    socket_type::handshake_type get_handshake_type() {
+        return m_is_server ? asio::ssl::stream_base::server : asio::ssl::stream_base::client;
+    }
+
+    io_service_ptr m_io_service;
+    strand_ptr m_strand;
+    context_ptr m_context;
+    socket_ptr m_socket;
+    ws::uri_ptr m_uri;
+    bool m_is_server = false;
+    ws::lib::error_code m_ec;
+    ws::connection_hdl m_hdl;
+    socket_init_handler m_socket_init_handler;
+    tls_init_handler m_tls_init_handler;
+};
+
+/// @brief Per-endpoint socket component, hands its handlers to new connections
+class endpoint {
+public:
+    typedef endpoint type;
+    typedef connection socket_con_type;
+    typedef socket_con_type::ptr socket_con_ptr;
+
+    explicit endpoint() {}
+
+    bool is_secure() const { return true; }
+
+    void set_socket_init_handler(socket_init_handler h) { m_socket_init_handler = h; }
+
+    void set_tls_init_handler(tls_init_handler h) { m_tls_init_handler = h; }
+
+protected:
+    ws::lib::error_code init(socket_con_ptr scon) {
+        scon->set_socket_init_handler(m_socket_init_handler);
+        scon->set_tls_init_handler(m_tls_init_handler);
+        return ws::lib::error_code();
+    }
+
+private:
+    socket_init_handler m_socket_init_handler;
+    tls_init_handler m_tls_init_handler;
+};
+
+}  // namespace rx_tls_socket
+
+/**
+ * @brief websocketpp client config used by wsClient
+ *
+ * asio_tls_client with the TLS socket policy swapped for rx_tls_socket and
+ * messages drawn from a per-connection pool of padded buffers
+ * (PooledConMsgManager).
+ */
+struct ArbClientConfig : public websocketpp::config::asio_tls_client {
+    typedef ArbClientConfig type;
+    typedef websocketpp::config::asio_tls_client base;
+
+    typedef base::concurrency_type concurrency_type;
+    typedef base::request_type request_type;
+    typedef base::response_type response_type;
+    typedef websocketpp::message_buffer::message<PooledConMsgManager> message_type;
+    typedef PooledConMsgManager<message_type> con_msg_manager_type;
+    typedef websocketpp::message_buffer::alloc::endpoint_msg_manager<con_msg_manager_type>
+        endpoint_msg_manager_type;
+    typedef base::alog_type alog_type;
+    typedef base::elog_type elog_type;
+    typedef base::rng_type rng_type;
+
+    struct transport_config : public base::transport_config {
+        typedef type::concurrency_type concurrency_type;
+        typedef type::alog_type alog_type;
+        typedef type::elog_type elog_type;
+        typedef type::request_type request_type;
+        typedef type::response_type response_type;
+        typedef rx_tls_socket::endpoint socket_type;
+    };
+
+    typedef websocketpp::transport::asio::endpoint<transport_config> transport_type;
+};
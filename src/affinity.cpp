@@ -0,0 +1,38 @@
+#include "affinity.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <sched.h>
+
+/**
+ * Implementation notes:
+ * - Affinity is set before the scheduling class, so a real-time thread
+ *   never spins on a core it was not meant to own
+ * - pthread functions return the error code instead of setting errno
+ */
+bool applyThreadPolicy(pthread_t thread, int core, int rt_priority, const char* name)
+{
+    bool ok = true;
+    if (core >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        int err = pthread_setaffinity_np(thread, sizeof(set), &set);
+        if (err != 0) {
+            std::cerr << "failed to pin " << name << " thread to core " << core
+                      << ": " << std::strerror(err) << "\n";
+            ok = false;
+        }
+    }
+    if (rt_priority > 0) {
+        sched_param param{};
+        param.sched_priority = rt_priority;
+        int err = pthread_setschedparam(thread, SCHED_FIFO, &param);
+        if (err != 0) {
+            std::cerr << "failed to set SCHED_FIFO on " << name << " thread: "
+                      << std::strerror(err) << "\n";
+            ok = false;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,131 @@
+#include "backtest.hpp"
+#include "work_pool.hpp"
+#include <algorithm>
+#include <memory>
+
+size_t BookTape::size() const {
+    size_t n = 0;
+    for (const auto& pair : books)
+        n += pair.size();
+    return n;
+}
+
+void BookTape::restore(const TapeBook& book, L2OrderBook& ob) const {
+    const Ticks* price = prices.data() + book.levels;
+    const Lots* quantity = quantities.data() + book.levels;
+    std::copy_n(price, book.askSize, ob.askPrice);
+    std::copy_n(quantity, book.askSize, ob.askQuantity);
+    std::copy_n(price + book.askSize, book.bidSize, ob.bidPrice);
+    std::copy_n(quantity + book.askSize, book.bidSize, ob.bidQuantity);
+    ob.askSize = book.askSize;
+    ob.bidSize = book.bidSize;
+    ob.t = book.t;
+    ob.rxTime = book.rxTime;
+    ob.scale = book.scale;
+}
+
+/**
+ * Implementation notes:
+ * - One L2OrderBook is reused as the decode buffer, so loading costs no
+ *   allocation beyond the growth of the tape's vectors
+ */
+void loadTape(ReplayFeed& feed, const config& cfg, BookTape& tape) {
+    auto ob = std::make_unique<L2OrderBook>();
+    int exchange, pair;
+
+    while (feed.next(exchange, pair, *ob)) {
+        if (!cfg.exchanges[exchange] || !cfg.pairs[pair]) {
+            tape.skipped++;
+            continue;
+        }
+        tape.books[pair].push_back({ob->t, ob->rxTime, tape.prices.size(),
+                                    static_cast<uint16_t>(ob->askSize), static_cast<uint16_t>(ob->bidSize),
+                                    exchange, ob->scale});
+        tape.prices.insert(tape.prices.end(), ob->askPrice, ob->askPrice + ob->askSize);
+        tape.prices.insert(tape.prices.end(), ob->bidPrice, ob->bidPrice + ob->bidSize);
+        tape.quantities.insert(tape.quantities.end(), ob->askQuantity, ob->askQuantity + ob->askSize);
+        tape.quantities.insert(tape.quantities.end(), ob->bidQuantity, ob->bidQuantity + ob->bidSize);
+    }
+    tape.skipped += feed.skipped();
+}
+
+namespace {
+
+/**
+ * @brief Replays one pair's books under one variant
+ *
+ * Mirrors process(): the updated book replaces its exchange's local copy,
+ * every book is aged, and the surviving exchange pairs are detected
+ * serially.
+ */
+BacktestResult backtestPair(const BookTape& tape, int pair, const config& cfg)
+{
+    std::vector<L2OrderBook> local_books(kTotalExchanges);
+    std::vector<Opportunity> out_opps;
+    std::vector<ExchangePair> candidates;
+    std::vector<DetectLane> lanes(1);
+    candidates.reserve(kTotalExchanges * kTotalExchanges);
+    out_opps.reserve(kTotalExchanges * kTotalExchanges);
+    lanes[0].found.reserve(kTotalExchanges * kTotalExchanges);
+    BacktestResult result;
+
+    int64_t fees[kTotalExchanges][kTotalExchanges];
+    for (int i = 0; i < kTotalExchanges; ++i)
+        for (int j = 0; j < kTotalExchanges; ++j)
+            fees[i][j] = feeUnits(cfg.fees[i] + cfg.fees[j]);
+
+    for (const TapeBook& book : tape.books[pair]) {
+        int updated = book.exchange;
+        L2OrderBook& ob = local_books[updated];
+        tape.restore(book, ob);
+        if (!computeDepth(ob, toFixed(cfg.max_order_size, ob.scale.qty_decimals)))
+            result.overflows++;
+
+        bool stale[kTotalExchanges];
+        for (int i = 0; i < kTotalExchanges; ++i)
+            stale[i] = isStale(bookAgeUs(local_books[i], book.t), cfg.max_book_age_ms[i]);
+
+        result.stale_skipped += selectPairs(local_books.data(), updated, cfg, fees, stale, candidates);
+        result.pairs_pruned += detectPairs(local_books.data(), candidates.data(),
+                                           static_cast<int>(candidates.size()), cfg.min_profit, book.rxTime,
+                                           nullptr, 0, lanes, out_opps);
+        for (const Opportunity& opp : out_opps) {
+            result.opportunities++;
+            result.notional += opp.order_size * opp.buy_vwap;
+            result.profit += opp.net_profit;
+        }
+        result.updates++;
+    }
+    return result;
+}
+
+}  // namespace
+
+/**
+ * Implementation notes:
+ * - Tasks are (variant, pair) combinations with books, handed out by a
+ *   WorkStealingPool so a long pair does not hold up the other threads
+ * - Each task owns its books and buffers and writes only its own result
+ *   slot, so tasks share nothing but the read-only tape
+ */
+std::vector<std::array<BacktestResult, kTotalPairs>> runBacktest(
+    const BookTape& tape, const config& cfg, const std::vector<BacktestVariant>& variants, int threads)
+{
+    std::vector<std::array<BacktestResult, kTotalPairs>> results(variants.size());
+    std::vector<std::pair<int, int>> tasks;
+    for (int v = 0; v < static_cast<int>(variants.size()); ++v)
+        for (int pair = 0; pair < kTotalPairs; ++pair)
+            if (!tape.books[pair].empty())
+                tasks.push_back({v, pair});
+
+    WorkStealingPool pool(std::max(threads, 1) - 1);
+    pool.parallelFor(static_cast<int>(tasks.size()), [&](int index, int) {
+        auto [v, pair] = tasks[index];
+        config run = cfg;
+        run.min_profit = variants[v].min_profit;
+        run.max_order_size = variants[v].max_order_size;
+        std::copy_n(variants[v].fees, kTotalExchanges, run.fees);
+        results[v][pair] = backtestPair(tape, pair, run);
+    });
+    return results;
+}
@@ -0,0 +1,193 @@
+#include "depth_kernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ARB_X86 1
+#endif
+
+/**
+ * Implementation notes:
+ * - All kernels compute unclamped prefix sums, then clamp only the level
+ *   that crosses max_lots; every level before it is taken in full, so this
+ *   matches a min(quantity, remaining) walk
+ * - Prefix sums are done in-register (log2(width) shift+add steps) and the
+ *   running total is carried across blocks by broadcasting the last lane
+ * - Integer sums are exact, so every kernel produces identical output
+ * - AVX2 has no 64-bit multiply; its blocks use the 32x32->64 multiply and
+ *   hand over to the scalar loop as soon as a level does not fit in 32 bits
+ * - Quantities are non-negative, so the first lane reaching the limit is the
+ *   crossing level and the sweep stops at that block
+ */
+namespace {
+
+/**
+ * @brief Caps the cumulative entry at the crossing level
+ * @return Number of levels used (crossing level included)
+ */
+inline int clampAt(int lvl, const int64_t* price, int64_t max_lots,
+                   int64_t* cum_qty, int64_t* cum_cost)
+{
+    int64_t prev_q = lvl > 0 ? cum_qty[lvl - 1] : 0;
+    int64_t prev_c = lvl > 0 ? cum_cost[lvl - 1] : 0;
+    cum_qty[lvl] = max_lots;
+    cum_cost[lvl] = prev_c + (max_lots - prev_q) * price[lvl];
+    return lvl + 1;
+}
+
+/**
+ * @brief Scalar continuation used for the levels left after the last full vector
+ * @return Number of levels used
+ */
+inline int finishScalar(int lvl, const int64_t* qty, const int64_t* price, int size,
+                        int64_t max_lots, int64_t* cum_qty, int64_t* cum_cost)
+{
+    int64_t total_q = lvl > 0 ? cum_qty[lvl - 1] : 0;
+    int64_t total_c = lvl > 0 ? cum_cost[lvl - 1] : 0;
+    for (; lvl < size; ++lvl) {
+        // Test before adding so an oversized level never overflows the sums
+        if (qty[lvl] >= max_lots - total_q)
+            return clampAt(lvl, price, max_lots, cum_qty, cum_cost);
+        total_q += qty[lvl];
+        total_c += qty[lvl] * price[lvl];
+        cum_qty[lvl] = total_q;
+        cum_cost[lvl] = total_c;
+    }
+    return size;
+}
+
+#ifdef ARB_X86
+/// @brief Inclusive prefix sum of 4 int64 lanes
+__attribute__((target("avx2"))) inline __m256i prefix4(__m256i x)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    // [0, x0, x1, x2]
+    x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03));
+    // [0, 0, x0, x1]
+    x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F));
+    return x;
+}
+
+/// @brief Inclusive prefix sum of 8 int64 lanes
+__attribute__((target("avx512f"))) inline __m512i prefix8(__m512i x)
+{
+    x = _mm512_add_epi64(x, _mm512_maskz_permutexvar_epi64(0xFE, _mm512_set_epi64(6, 5, 4, 3, 2, 1, 0, 0), x));
+    x = _mm512_add_epi64(x, _mm512_maskz_permutexvar_epi64(0xFC, _mm512_set_epi64(5, 4, 3, 2, 1, 0, 0, 0), x));
+    x = _mm512_add_epi64(x, _mm512_maskz_permutexvar_epi64(0xF0, _mm512_set_epi64(3, 2, 1, 0, 0, 0, 0, 0), x));
+    return x;
+}
+#endif
+
+}  // namespace
+
+int depthKernelScalar(const int64_t* qty, const int64_t* price, int size,
+                      int64_t max_lots, int64_t* cum_qty, int64_t* cum_cost)
+{
+    if (max_lots <= 0)
+        return 0;
+    return finishScalar(0, qty, price, size, max_lots, cum_qty, cum_cost);
+}
+
+#ifdef ARB_X86
+__attribute__((target("avx2")))
+int depthKernelAvx2(const int64_t* qty, const int64_t* price, int size,
+                    int64_t max_lots, int64_t* cum_qty, int64_t* cum_cost)
+{
+    if (max_lots <= 0)
+        return 0;
+
+    const __m256i below = _mm256_set1_epi64x(max_lots - 1);
+    const __m256i high = _mm256_set1_epi64x(static_cast<int64_t>(0xFFFFFFFF00000000ULL));
+    __m256i carry_q = _mm256_setzero_si256();
+    __m256i carry_c = _mm256_setzero_si256();
+    int lvl = 0;
+    for (; lvl + 4 <= size; lvl += 4) {
+        __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(qty + lvl));
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(price + lvl));
+        if (!_mm256_testz_si256(_mm256_or_si256(q, p), high))
+            break;
+        __m256i c = _mm256_mul_epu32(q, p);
+        q = _mm256_add_epi64(prefix4(q), carry_q);
+        c = _mm256_add_epi64(prefix4(c), carry_c);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(cum_qty + lvl), q);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(cum_cost + lvl), c);
+
+        int crossed = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(q, below)));
+        if (crossed)
+            return clampAt(lvl + __builtin_ctz(crossed), price, max_lots, cum_qty, cum_cost);
+
+        carry_q = _mm256_permute4x64_epi64(q, _MM_SHUFFLE(3, 3, 3, 3));
+        carry_c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    return finishScalar(lvl, qty, price, size, max_lots, cum_qty, cum_cost);
+}
+
+__attribute__((target("avx512f,avx512dq")))
+int depthKernelAvx512(const int64_t* qty, const int64_t* price, int size,
+                      int64_t max_lots, int64_t* cum_qty, int64_t* cum_cost)
+{
+    if (max_lots <= 0)
+        return 0;
+
+    const __m512i limit = _mm512_set1_epi64(max_lots);
+    const __m512i last = _mm512_set1_epi64(7);
+    __m512i carry_q = _mm512_setzero_si512();
+    __m512i carry_c = _mm512_setzero_si512();
+    int lvl = 0;
+    for (; lvl + 8 <= size; lvl += 8) {
+        __m512i q = _mm512_loadu_si512(qty + lvl);
+        __m512i c = _mm512_mullo_epi64(q, _mm512_loadu_si512(price + lvl));
+        q = _mm512_add_epi64(prefix8(q), carry_q);
+        c = _mm512_add_epi64(prefix8(c), carry_c);
+        _mm512_storeu_si512(cum_qty + lvl, q);
+        _mm512_storeu_si512(cum_cost + lvl, c);
+
+        __mmask8 crossed = _mm512_cmpge_epi64_mask(q, limit);
+        if (crossed)
+            return clampAt(lvl + __builtin_ctz(crossed), price, max_lots, cum_qty, cum_cost);
+
+        carry_q = _mm512_permutexvar_epi64(last, q);
+        carry_c = _mm512_permutexvar_epi64(last, c);
+    }
+    return finishScalar(lvl, qty, price, size, max_lots, cum_qty, cum_cost);
+}
+#else
+int depthKernelAvx2(const int64_t* qty, const int64_t* price, int size,
+                    int64_t max_lots, int64_t* cum_qty, int64_t* cum_cost)
+{
+    return depthKernelScalar(qty, price, size, max_lots, cum_qty, cum_cost);
+}
+
+int depthKernelAvx512(const int64_t* qty, const int64_t* price, int size,
+                      int64_t max_lots, int64_t* cum_qty, int64_t* cum_cost)
+{
+    return depthKernelScalar(qty, price, size, max_lots, cum_qty, cum_cost);
+}
+#endif
+
+/**
+ * Implementation notes:
+ * - __builtin_cpu_init() is called explicitly because selection may run
+ *   from a static initializer, before libgcc has probed the CPU
+ * - The AVX-512 kernel needs DQ for the 64-bit multiply
+ */
+DepthKernel selectDepthKernel()
+{
+#ifdef ARB_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq"))
+        return depthKernelAvx512;
+    if (__builtin_cpu_supports("avx2"))
+        return depthKernelAvx2;
+#endif
+    return depthKernelScalar;
+}
+
+const char* depthKernelName()
+{
+    DepthKernel kernel = selectDepthKernel();
+    if (kernel == depthKernelAvx512)
+        return "avx512";
+    if (kernel == depthKernelAvx2)
+        return "avx2";
+    return "scalar";
+}
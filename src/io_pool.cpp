@@ -0,0 +1,63 @@
+#include "io_pool.hpp"
+#include "affinity.hpp"
+
+/**
+ * Implementation notes:
+ * - Work guards are created before the threads start, so run() does not
+ *   return while connections are still being set up
+ * - Each io_service gets a concurrency hint of 1: it is only ever run by
+ *   its own thread, which lets asio skip internal locking
+ * - Busy-poll threads exit once their loop is stopped, like run() does
+ */
+IoPool::IoPool(int threads, bool busy_poll)
+{
+    if (threads < 1)
+        threads = 1;
+    services_.reserve(threads);
+    work_.reserve(threads);
+    threads_.reserve(threads);
+    for (int i = 0; i < threads; i++) {
+        services_.emplace_back(std::make_unique<IoService>(1));
+        work_.emplace_back(boost::asio::make_work_guard(*services_.back()));
+    }
+    for (int i = 0; i < threads; i++) {
+        threads_.emplace_back([service = services_[i].get(), busy_poll] {
+            if (!busy_poll) {
+                service->run();
+                return;
+            }
+            while (!service->stopped()) {
+                if (service->poll() == 0)
+                    cpuRelax();
+            }
+        });
+    }
+}
+
+IoPool::~IoPool()
+{
+    stop();
+}
+
+/**
+ * Implementation notes:
+ * - Loops are stopped rather than drained: pending handlers reference
+ *   clients that are about to be destroyed
+ * - The services themselves stay alive until the destructor, since the
+ *   clients' sockets still deregister from them when destroyed
+ */
+void IoPool::stop()
+{
+    for (auto& guard : work_)
+        guard.reset();
+    for (auto& service : services_)
+        service->stop();
+    for (auto& thread : threads_)
+        if (thread.joinable())
+            thread.join();
+}
+
+IoService& IoPool::next()
+{
+    return *services_[assigned_++ % services_.size()];
+}
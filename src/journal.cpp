@@ -0,0 +1,326 @@
+#include "journal.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+/// @brief File size holding the header and capacity records
+size_t journalBytes(uint64_t capacity) {
+    return sizeof(JournalHeader) + capacity * sizeof(JournalRecord);
+}
+
+/// @brief Whether a mapped header describes a journal this build can read
+bool compatible(const JournalHeader& header) {
+    return std::memcmp(header.magic, kJournalMagic, sizeof(kJournalMagic)) == 0 &&
+           header.version == kJournalVersion && header.header_size == sizeof(JournalHeader) &&
+           header.record_size == sizeof(JournalRecord);
+}
+
+/// @brief Copies a name into a fixed header slot, NUL-terminated
+void copyName(char (&slot)[kJournalNameSize], std::string_view name) {
+    size_t n = std::min(name.size(), sizeof(slot) - 1);
+    std::memcpy(slot, name.data(), n);
+    slot[n] = '\0';
+}
+
+/// @brief Base currency of a pair name ("BTC" of "BTC/USDT")
+std::string_view nameBase(std::string_view pair) {
+    return pair.substr(0, pair.find('/'));
+}
+
+/// @brief Quote currency of a pair name ("USDT" of "BTC/USDT")
+std::string_view nameQuote(std::string_view pair) {
+    size_t slash = pair.find('/');
+    return slash == std::string_view::npos ? std::string_view() : pair.substr(slash + 1);
+}
+
+/// @brief Currency a leg of a record receives
+std::string_view legOutputName(const JournalReader& reader, const JournalRecord& record, int k) {
+    std::string_view pair = reader.pairName(record.pairs[k]);
+    return (record.buy_base >> k) & 1 ? nameBase(pair) : nameQuote(pair);
+}
+
+/// @brief Currency a cycle record starts and ends in
+std::string_view startName(const JournalReader& reader, const JournalRecord& record) {
+    std::string_view pair = reader.pairName(record.pairs[0]);
+    return record.buy_base & 1 ? nameQuote(pair) : nameBase(pair);
+}
+
+/// @brief Nanoseconds since the epoch of a time point
+int64_t sinceEpochNs(std::chrono::high_resolution_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+}  // namespace
+
+JournalRecord toJournalRecord(const Opportunity& opp) {
+    JournalRecord record{};
+    record.kind = kJournalPair;
+    record.leg_count = 2;
+    record.buy_base = 1;
+    record.exchanges[0] = static_cast<uint8_t>(opp.buy_exchange);
+    record.exchanges[1] = static_cast<uint8_t>(opp.sell_exchange);
+    record.pairs[0] = record.pairs[1] = static_cast<uint8_t>(opp.pair);
+    record.levels[0] = static_cast<uint16_t>(opp.buy_levels);
+    record.levels[1] = static_cast<uint16_t>(opp.sell_levels);
+    record.detection_time_ns = sinceEpochNs(opp.detection_time);
+    record.detection_latency_us = opp.detection_latency_us;
+    record.book_age_us[0] = opp.buy_book_age_us;
+    record.book_age_us[1] = opp.sell_book_age_us;
+    record.vwap[0] = opp.buy_vwap;
+    record.vwap[1] = opp.sell_vwap;
+    record.amount = opp.order_size;
+    record.profit_pct = opp.profit_pct;
+    record.net_profit = opp.net_profit;
+    return record;
+}
+
+JournalRecord toJournalRecord(const CycleOpportunity& cycle) {
+    JournalRecord record{};
+    record.kind = kJournalCycle;
+    record.leg_count = kCycleLegs;
+    for (int k = 0; k < kCycleLegs; k++) {
+        record.buy_base |= static_cast<uint8_t>(cycle.buy_base[k] ? 1 << k : 0);
+        record.exchanges[k] = static_cast<uint8_t>(cycle.exchanges[k]);
+        record.pairs[k] = static_cast<uint8_t>(cycle.pairs[k]);
+        record.levels[k] = static_cast<uint16_t>(cycle.levels[k]);
+        record.book_age_us[k] = cycle.book_age_us[k];
+    }
+    record.detection_time_ns = sinceEpochNs(cycle.detection_time);
+    record.detection_latency_us = cycle.detection_latency_us;
+    record.amount = cycle.start_amount;
+    record.end_amount = cycle.end_amount;
+    record.profit_pct = cycle.profit_pct;
+    record.net_profit = cycle.net_profit;
+    return record;
+}
+
+JournalWriter::~JournalWriter() {
+    if (header_)
+        munmap(header_, mapped_bytes_);
+    if (fd_ != -1)
+        close(fd_);
+}
+
+/**
+ * Implementation notes:
+ * - A new file is sized for kJournalInitialRecords up front; the unused
+ *   tail is sparse, so it costs no disk until written
+ * - An existing file is appended to after its committed records; anything
+ *   past record_count is the remains of a write cut short and is
+ *   overwritten
+ */
+void JournalWriter::open(const std::string& path) {
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ == -1)
+        throw std::runtime_error("cannot open journal " + path + ": " + std::strerror(errno));
+    struct stat st;
+    if (fstat(fd_, &st) != 0)
+        throw std::runtime_error("cannot stat journal " + path + ": " + std::strerror(errno));
+
+    if (st.st_size == 0) {
+        map(kJournalInitialRecords);
+        std::memcpy(header_->magic, kJournalMagic, sizeof(kJournalMagic));
+        header_->version = kJournalVersion;
+        header_->header_size = sizeof(JournalHeader);
+        header_->record_size = sizeof(JournalRecord);
+        header_->exchange_count = kTotalExchanges;
+        header_->pair_count = kTotalPairs;
+        header_->created_ns = sinceEpochNs(std::chrono::high_resolution_clock::now());
+        for (int i = 0; i < kTotalExchanges; i++)
+            copyName(header_->exchanges[i], kExchanges[i]);
+        for (int i = 0; i < kTotalPairs; i++)
+            copyName(header_->pairs[i], kPairs[i]);
+        count_ = 0;
+        return;
+    }
+
+    if (static_cast<size_t>(st.st_size) < sizeof(JournalHeader))
+        throw std::runtime_error("truncated journal " + path);
+    map((static_cast<size_t>(st.st_size) - sizeof(JournalHeader)) / sizeof(JournalRecord));
+    if (!compatible(*header_))
+        throw std::runtime_error(path + " is not a version " + std::to_string(kJournalVersion) +
+                                 " opportunity journal; move it aside to start a new one");
+    count_ = header_->record_count;
+    if (count_ > capacity_)
+        throw std::runtime_error("corrupt journal " + path + ": more records than the file holds");
+}
+
+/**
+ * Implementation notes:
+ * - The record is complete before record_count is released, so a reader
+ *   that acquires the count sees every byte of the records it covers
+ * - Growing doubles the file and remaps it: O(log n) remaps in total; a
+ *   file opened with no room for records (just a header) grows to
+ *   kJournalInitialRecords instead
+ */
+void JournalWriter::append(const JournalRecord& record) {
+    if (count_ == capacity_)
+        map(std::max<uint64_t>(capacity_ * 2, kJournalInitialRecords));
+    records_[count_] = record;
+    ++count_;
+    __atomic_store_n(&header_->record_count, count_, __ATOMIC_RELEASE);
+}
+
+void JournalWriter::map(uint64_t capacity) {
+    size_t bytes = journalBytes(capacity);
+    if (ftruncate(fd_, static_cast<off_t>(bytes)) != 0)
+        throw std::runtime_error(std::string("cannot grow journal: ") + std::strerror(errno));
+    if (header_)
+        munmap(header_, mapped_bytes_);
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base == MAP_FAILED) {
+        header_ = nullptr;
+        throw std::runtime_error(std::string("cannot map journal: ") + std::strerror(errno));
+    }
+    header_ = static_cast<JournalHeader*>(base);
+    records_ = reinterpret_cast<JournalRecord*>(static_cast<char*>(base) + sizeof(JournalHeader));
+    capacity_ = capacity;
+    mapped_bytes_ = bytes;
+}
+
+JournalReader::~JournalReader() {
+    if (header_)
+        munmap(const_cast<JournalHeader*>(header_), mapped_bytes_);
+    if (fd_ != -1)
+        close(fd_);
+}
+
+bool JournalReader::open(const std::string& path) {
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ == -1)
+        return false;
+    if (!map() || !compatible(*header_)) {
+        munmap(const_cast<JournalHeader*>(header_), mapped_bytes_);
+        header_ = nullptr;
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    refresh();
+    return true;
+}
+
+/**
+ * Implementation notes:
+ * - The writer grows the file before it commits records into the new
+ *   space, so remapping at the current file size always covers the count
+ */
+void JournalReader::refresh() {
+    uint64_t committed = __atomic_load_n(&header_->record_count, __ATOMIC_ACQUIRE);
+    if (journalBytes(committed) > mapped_bytes_)
+        map();
+    uint64_t mapped = (mapped_bytes_ - sizeof(JournalHeader)) / sizeof(JournalRecord);
+    count_ = std::min(committed, mapped);
+}
+
+bool JournalReader::map() {
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(JournalHeader))
+        return false;
+    void* base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd_, 0);
+    if (base == MAP_FAILED)
+        return false;
+    if (header_)
+        munmap(const_cast<JournalHeader*>(header_), mapped_bytes_);
+    header_ = static_cast<const JournalHeader*>(base);
+    records_ = reinterpret_cast<const JournalRecord*>(static_cast<const char*>(base) + sizeof(JournalHeader));
+    mapped_bytes_ = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+std::string_view JournalReader::exchangeName(int i) const {
+    if (i < 0 || i >= static_cast<int>(header_->exchange_count) || i >= kJournalMaxNames)
+        return "?";
+    return {header_->exchanges[i], strnlen(header_->exchanges[i], kJournalNameSize)};
+}
+
+std::string_view JournalReader::pairName(int i) const {
+    if (i < 0 || i >= static_cast<int>(header_->pair_count) || i >= kJournalMaxNames)
+        return "?";
+    return {header_->pairs[i], strnlen(header_->pairs[i], kJournalNameSize)};
+}
+
+void formatText(std::ostream& out, const JournalReader& reader, const JournalRecord& record) {
+    if (record.kind == kJournalPair) {
+        std::string_view pair = reader.pairName(record.pairs[0]);
+        out << "\nArbitrage Opportunity (" << pair << "):\n"
+            << "Buy on " << reader.exchangeName(record.exchanges[0])
+            << " at " << std::fixed << std::setprecision(2) << record.vwap[0]
+            << " using " << record.levels[0] << " levels\n"
+            << "Sell on " << reader.exchangeName(record.exchanges[1])
+            << " at " << record.vwap[1]
+            << " using " << record.levels[1] << " levels\n"
+            << "Profit: " << std::setprecision(3) << record.profit_pct << "%\n"
+            << "Order Size: " << std::setprecision(6) << record.amount << " " << nameBase(pair) << "\n"
+            << "Net Profit: " << std::setprecision(2) << record.net_profit << "\n"
+            << "Market Impact: " << (record.levels[0] + record.levels[1]) << " levels deep\n"
+            << "Detection Latency: " << std::setprecision(2) << record.detection_latency_us << " μs\n"
+            << "Book Age: buy " << std::setprecision(0) << record.book_age_us[0]
+            << " μs, sell " << record.book_age_us[1] << " μs\n"
+            << std::string(50, '-') << "\n";
+        return;
+    }
+
+    std::string_view start = startName(reader, record);
+    out << "\nTriangular Opportunity (" << start;
+    for (int k = 0; k < record.leg_count && k < kCycleLegs; k++)
+        out << " -> " << legOutputName(reader, record, k);
+    out << "):\n";
+    for (int k = 0; k < record.leg_count && k < kCycleLegs; k++) {
+        out << "Leg " << (k + 1) << ": " << ((record.buy_base >> k) & 1 ? "Buy " : "Sell ")
+            << reader.pairName(record.pairs[k]) << " on " << reader.exchangeName(record.exchanges[k])
+            << " using " << record.levels[k] << " levels\n";
+    }
+    out << "Start Amount: " << std::fixed << std::setprecision(6) << record.amount << " " << start << "\n"
+        << "Profit: " << std::setprecision(3) << record.profit_pct << "%\n"
+        << "Net Profit: " << std::setprecision(6) << record.net_profit << " " << start << "\n"
+        << "Detection Latency: " << std::setprecision(2) << record.detection_latency_us << " μs\n"
+        << "Book Age: " << std::setprecision(0) << record.book_age_us[0] << " / "
+        << record.book_age_us[1] << " / " << record.book_age_us[2] << " μs\n"
+        << std::string(50, '-') << "\n";
+}
+
+void formatCsvHeader(std::ostream& out) {
+    out << "index,kind,detection_time_ns,detection_latency_us";
+    for (int k = 1; k <= kCycleLegs; k++)
+        out << ",leg" << k << "_exchange,leg" << k << "_pair,leg" << k << "_side,leg" << k
+            << "_levels,leg" << k << "_book_age_us";
+    out << ",buy_vwap,sell_vwap,amount,end_amount,profit_pct,net_profit\n";
+}
+
+/**
+ * Implementation notes:
+ * - Legs a record does not use are left as empty fields, so pair and
+ *   cycle rows share one set of columns
+ */
+void formatCsv(std::ostream& out, const JournalReader& reader, uint64_t index, const JournalRecord& record) {
+    out << index << "," << (record.kind == kJournalPair ? "pair" : "cycle") << ","
+        << record.detection_time_ns << "," << std::fixed << std::setprecision(2) << record.detection_latency_us;
+    for (int k = 0; k < kCycleLegs; k++) {
+        if (k >= record.leg_count) {
+            out << ",,,,,";
+            continue;
+        }
+        out << "," << reader.exchangeName(record.exchanges[k]) << "," << reader.pairName(record.pairs[k])
+            << "," << ((record.buy_base >> k) & 1 ? "buy" : "sell") << "," << record.levels[k]
+            << "," << std::setprecision(0) << record.book_age_us[k];
+    }
+    out << std::setprecision(8);
+    if (record.kind == kJournalPair)
+        out << "," << record.vwap[0] << "," << record.vwap[1];
+    else
+        out << ",,";
+    out << "," << record.amount << ",";
+    if (record.kind == kJournalCycle)
+        out << record.end_amount;
+    out << "," << record.profit_pct << "," << record.net_profit << "\n";
+}
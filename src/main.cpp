@@ -1,4 +1,10 @@
 #include "orderbook.hpp"
+#include "depth_kernels.hpp"
+#include "affinity.hpp"
+#include "journal.hpp"
+#include "recorder.hpp"
+#include "replay.hpp"
+#include "triangular.hpp"
 #include "utils.hpp"
 #include "ws_client.hpp"
 #include <csignal>
@@ -12,17 +18,71 @@
 #include <sys/resource.h>
 #include <unistd.h>
 #include <iomanip> 
+#include <algorithm>
+#include <limits>
 
-/// @brief Semaphores for synchronizing orderbook updates and database writes
-std::counting_semaphore<kTotalExchanges> sem(0);
-std::counting_semaphore<kTotalExchanges> sem1(0);
+/// @brief Books, event queues and detection metrics of every pair, indexed by pair
+std::vector<PairBooks> g_markets(kTotalPairs);
 
-/// @brief Global metrics instance for tracking system performance
+/// @brief Results of all pair workers, consumed by the database writer
+OpportunitySink g_opportunity_sink;
+
+/// @brief Event queue and metrics of the triangular cycle detector
+CycleEngine g_cycles;
+
+/// @brief Global metrics instance for feed-side statistics and start time
 Metrics g_metrics;
 
+/// @brief Full-depth recorder of every published book, null unless "record_dir" is set
+std::unique_ptr<BookRecorder> g_recorder;
+
+/// @brief Progress of the replay, when one replaces the live feeds
+ReplayStats g_replay;
+
+/// @brief Event loops of the live feeds, null when replaying
+/// @note Declared before connections, whose clients are bound to its loops
+std::unique_ptr<IoPool> g_io_pool;
+
 /// @brief Vector of WebSocket client connections to exchanges
 std::vector<std::unique_ptr<wsClient>> connections;
 
+/// @brief Set once the process should stop, by the quit command or SIGINT/SIGTERM
+std::atomic<bool> g_shutdown{false};
+
+/// @brief Asks main() to run the orderly shutdown; any thread
+void requestShutdown() {
+    g_shutdown.store(true);
+    g_shutdown.notify_all();
+}
+
+/**
+ * @brief Turns SIGINT and SIGTERM into a shutdown request
+ *
+ * The signals are blocked in every thread before any starts, so they are
+ * only ever taken here, by sigwait(), and never interrupt a writer.
+ *
+ * @param signals The blocked stop signals
+ */
+void signalThread(sigset_t signals) {
+    int sig;
+    sigwait(&signals, &sig);
+    requestShutdown();
+}
+
+/**
+ * @brief Tears down the live feeds in the only safe order
+ *
+ * The loops are stopped and joined first so no handler runs on a client
+ * being destroyed, then the clients are destroyed while the loops their
+ * sockets belong to still exist, then the loops.
+ */
+void closeFeeds() {
+    if (g_io_pool)
+        g_io_pool->stop();
+    connections.clear();
+    g_io_pool.reset();
+}
+
 /**
  * @brief Displays detailed system resource usage and performance metrics
  * 
@@ -48,6 +108,7 @@ void displaySystemDetails() {
         std::cout << "\nSystem Details:\n"
                   << "CPU Cores: " << num_cores << "\n"
                   << "Active Threads: " << std::thread::hardware_concurrency() << "\n"
+                  << "Depth Kernel: " << depthKernelName() << "\n"
                   << "Process ID: " << current_pid << "\n"
                   << "\nMemory Usage:\n"
                   << "  Total RAM: " << std::fixed << std::setprecision(2) << total_ram << " MB\n"
@@ -79,60 +140,120 @@ void displayHelp() {
 
 /**
  * @brief Displays the detailed metrics information
+ *
+ * Detection counters are kept per pair by each worker and summed here;
+ * a per-pair breakdown follows the totals when several pairs are enabled.
  */
 void displayMetrics() {
     auto now = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - g_metrics.start_time);
-    uint64_t updates = g_metrics.updates_processed.load(std::memory_order_relaxed);
-    uint64_t opps = g_metrics.opportunities_found.load(std::memory_order_relaxed);
+    uint64_t updates = 0, opps = 0, superseded = 0, dropped = 0, pruned = 0, stale = 0;
+    uint64_t total_latency = 0, min_latency = std::numeric_limits<uint64_t>::max(), max_latency = 0;
+    int active_pairs = 0;
+    for (const auto& market : g_markets) {
+        const Metrics& m = market.metrics;
+        updates += m.updates_processed.load(std::memory_order_relaxed);
+        opps += m.opportunities_found.load(std::memory_order_relaxed);
+        superseded += m.updates_superseded.load(std::memory_order_relaxed);
+        pruned += m.pairs_pruned.load(std::memory_order_relaxed);
+        stale += m.stale_skipped.load(std::memory_order_relaxed);
+        dropped += market.events.dropped();
+        total_latency += m.total_latency_us.load(std::memory_order_relaxed);
+        min_latency = std::min(min_latency, m.min_latency_us.load(std::memory_order_relaxed));
+        max_latency = std::max(max_latency, m.max_latency_us.load(std::memory_order_relaxed));
+        active_pairs += m.updates_processed.load(std::memory_order_relaxed) > 0;
+    }
     
     std::cout << "\nPerformance Metrics:\n"
               << "Runtime: " << duration.count() << " seconds\n"
               << "Updates Processed: " << updates << "\n"
+              << "Updates Superseded: " << superseded << "\n"
+              << "Updates Dropped: " << dropped << "\n"
+              << "Opportunities Dropped: " << g_opportunity_sink.droppedOpportunities() << "\n"
+              << "Summaries Dropped: " << g_opportunity_sink.droppedSummaries() << "\n"
+              << "Pairs Pruned: " << pruned << "\n"
+              << "Pairs Skipped (Stale Book): " << stale << "\n"
               << "Opportunities Found: " << opps << "\n";
 
+    uint64_t rx_samples = g_metrics.rx_delay_samples.load(std::memory_order_relaxed);
+    if (rx_samples > 0) {
+        std::cout << "Avg Socket-to-Handler Delay (μs): "
+                  << g_metrics.rx_delay_total_us.load(std::memory_order_relaxed) / rx_samples << "\n";
+    }
+
     if (opps > 0) {
-        uint64_t avg_latency = g_metrics.total_latency_us.load(std::memory_order_relaxed) / opps;
-        uint64_t min_latency = g_metrics.min_latency_us.load(std::memory_order_relaxed);
-        uint64_t max_latency = g_metrics.max_latency_us.load(std::memory_order_relaxed);
+        uint64_t avg_latency = total_latency / opps;
         
         std::cout << "Latency (μs):\n"
                   << "  Min: " << min_latency << "\n"
                   << "  Avg: " << avg_latency << "\n"
                   << "  Max: " << max_latency << "\n";
     }
+
+    uint64_t cycle_updates = g_cycles.metrics.updates_processed.load(std::memory_order_relaxed);
+    if (cycle_updates > 0) {
+        std::cout << "Triangular:\n"
+                  << "  Updates Processed: " << cycle_updates << "\n"
+                  << "  Updates Dropped: " << g_cycles.events.dropped() << "\n"
+                  << "  Cycles Pruned: " << g_cycles.metrics.pairs_pruned.load(std::memory_order_relaxed) << "\n"
+                  << "  Cycles Skipped (Stale Book): " << g_cycles.metrics.stale_skipped.load(std::memory_order_relaxed) << "\n"
+                  << "  Cycles Found: " << g_cycles.metrics.opportunities_found.load(std::memory_order_relaxed) << "\n"
+                  << "  Cycles Dropped: " << g_opportunity_sink.droppedCycles() << "\n";
+    }
+
+    if (!g_replay.source.empty()) {
+        std::cout << "Replay:\n"
+                  << "  Source: " << g_replay.source << "\n"
+                  << "  Books Replayed: " << g_replay.replayed.load(std::memory_order_relaxed) << "\n"
+                  << "  Books Skipped: " << g_replay.skipped.load(std::memory_order_relaxed) << "\n"
+                  << "  Status: " << (g_replay.done.load() ? "finished" : "running") << "\n";
+    }
+
+    if (g_recorder) {
+        std::cout << "Recorder:\n"
+                  << "  File: " << g_recorder->path() << "\n"
+                  << "  Books Recorded: " << g_recorder->recorded() << "\n"
+                  << "  Books Dropped: " << g_recorder->dropped() << "\n"
+                  << "  Size (MB): " << std::fixed << std::setprecision(2)
+                  << g_recorder->bytes() / (1024.0 * 1024.0) << "\n";
+    }
+
+    if (active_pairs > 1) {
+        std::cout << "Per Pair:\n";
+        for (int p = 0; p < kTotalPairs; p++) {
+            const Metrics& m = g_markets[p].metrics;
+            uint64_t pair_updates = m.updates_processed.load(std::memory_order_relaxed);
+            if (pair_updates == 0)
+                continue;
+            std::cout << "  " << kPairs[p] << ": " << pair_updates << " updates, "
+                      << m.opportunities_found.load(std::memory_order_relaxed) << " opportunities\n";
+        }
+    }
     std::cout << "\n";
 }
 /**
- * @brief Displays new arbitrage opportunities from the log file
+ * @brief Displays new arbitrage opportunities from the journal
  * 
- * Reads and displays new opportunities that have been logged since the last read.
- * Limits output to 80 lines (10 opportunities) at a time and adds small delays
- * to prevent console flooding.
+ * Renders the opportunities recorded since the last call, opening the
+ * journal on first use. Limits output to 10 opportunities at a time and
+ * adds small delays to prevent console flooding.
  * 
- * @param last_read_pos Reference to the last read position in the file
+ * @param journal Reader of the opportunity journal
+ * @param next_record Index of the first record not shown yet, advanced past those shown
  */
-void displayNewOpportunities(std::streampos& last_read_pos) {
-    std::ifstream opps_file(kOppStoragePath);
-    if (!opps_file) {
-        std::cerr << "Failed to open opportunities.txt\n";
+void displayNewOpportunities(JournalReader& journal, uint64_t& next_record) {
+    if (!journal.isOpen() && !journal.open(kJournalPath)) {
+        std::cerr << "Failed to open " << kJournalPath << "\n";
         return;
     }
-    opps_file.seekg(last_read_pos);
-    std::string line;
+    journal.refresh();
     int count = 0;
-    while (std::getline(opps_file, line)) {
-        std::cout << line << std::endl;
+    while (next_record < journal.count() && count < 10) {
+        formatText(std::cout, journal, journal.record(next_record++));
+        std::cout.flush();
         count++;
-        
-        if (count % 5 == 0) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-        }
-
-        if (count > 8*10) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
-    last_read_pos = opps_file.tellg();
-    opps_file.close();
 }
 
 /**
@@ -149,7 +270,8 @@ void commandProcessor() {
     std::string cmd;
     displayHelp();
     std::atomic<bool> is_running = true;
-    std::streampos last_read_pos = 0;
+    JournalReader journal;
+    uint64_t next_record = 0;
 
     while (is_running) {
         std::cout << "> ";
@@ -160,7 +282,7 @@ void commandProcessor() {
         }
         else if (cmd == "s" || cmd == "start") {
             std::cout << "Started displaying opportunities\n\n";
-            displayNewOpportunities(last_read_pos); 
+            displayNewOpportunities(journal, next_record);
         }
         else if (cmd == "m" || cmd == "metrics") {
             displayMetrics();
@@ -170,7 +292,7 @@ void commandProcessor() {
         }
         else if (cmd == "q" || cmd == "quit") {
             is_running = false;
-            kill(getpid(), SIGINT);
+            requestShutdown();
             break;
         }
         else if (!cmd.empty()) {
@@ -179,49 +301,153 @@ void commandProcessor() {
     }
 }
 
+/**
+ * @brief Replays the configured source, then reports and optionally exits
+ *
+ * Every book is detected in lock-step, so when the replay ends all of its
+ * results are already in the sink. With exit_when_done, a complete replay
+ * then requests the orderly shutdown, which writes and commits them
+ * before main() prints the metrics.
+ *
+ * @param feed Opened replay source
+ * @param cfg Configuration of the run
+ */
+void replayThread(ReplayFeed& feed, const config& cfg) {
+    auto start = std::chrono::steady_clock::now();
+    replayBooks(feed, cfg, g_markets, g_cycles, g_replay);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    bool stopped = g_replay.stop.load();
+    std::cout << "\nReplay " << (stopped ? "stopped" : "finished") << ": " << g_replay.replayed.load()
+              << " books in " << std::fixed << std::setprecision(2) << seconds << " s, "
+              << g_replay.skipped.load() << " skipped\n";
+
+    if (cfg.replay.exit_when_done && !stopped)
+        requestShutdown();
+}
+
 /**
  * @brief Main entry point for the arbitrage detection system
  * 
  * Program flow:
  * 1. Load configuration from JSON
- * 2. Initialize orderbooks and metrics
- * 3. Start processing thread for opportunity detection
- * 4. Start database writer thread for logging
- * 5. Connect to exchanges via WebSocket
+ * 2. Initialize metrics
+ * 3. Start one processing thread per enabled pair for opportunity detection,
+ *    plus the triangular cycle detector if enabled
+ * 4. Start database writer thread for logging, and the book recorder if enabled
+ * 5. Connect to exchanges via WebSocket, or start the replay if configured
  * 6. Start command processor for user interaction
- * 7. Clean up on exit
+ * 7. On quit, SIGINT or SIGTERM, stop every thread in order so the
+ *    database writer commits its last batch before exiting
  * 
  */
 int main() {
     simdjson::ondemand::parser kParser;
     config kConfig {};
 
+    // Block the stop signals before any thread starts, so every thread inherits the mask
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+    std::thread(signalThread, stop_signals).detach();
+
     try {
         const std::string kConfigPath = "../config/config.json";
         loadConfig(kConfigPath, kConfig, kParser);
-        
-        std::vector<L2OrderBook> orderbooks(kTotalExchanges);
-        std::vector<Opportunity> opportunities;
-        L2OrderBook new_ob;
 
+        // Open the replay source or the recording before any thread starts,
+        // so a bad path is reported as a startup error
+        const bool replaying = !kConfig.replay.path.empty();
+        ReplayFeed replay_feed;
+        if (replaying) {
+            replay_feed.open(kConfig.replay.path, kConfig);
+            g_replay.source = kConfig.replay.path;
+        } else if (!kConfig.record_dir.empty()) {
+            g_recorder = std::make_unique<BookRecorder>(kConfig.record_dir);
+        }
+        
         // Start metrics tracking
         g_metrics.start_time = std::chrono::high_resolution_clock::now();
         
-        // Start the main processing thread
-        std::thread process_thread(process, std::ref(orderbooks), 
-                                 std::ref(kConfig), std::ref(opportunities), std::ref(new_ob));
+        // Start one detection worker per enabled pair
+        std::vector<std::thread> process_threads;
+        for (int p = 0; p < kTotalPairs; p++) {
+            if (!kConfig.pairs[p]) continue;
+            process_threads.emplace_back(process, p, std::ref(g_markets[p]),
+                                         std::ref(kConfig), std::ref(g_opportunity_sink));
+        }
+
+        // Triangular cycles across the enabled pairs, on their own thread and queue
+        std::vector<Cycle> cycles;
+        std::thread cycle_thread;
+        if (kConfig.triangular) {
+            cycles = buildCycles(kConfig);
+            if (cycles.empty()) {
+                std::cerr << "triangular: the enabled pairs form no currency triangle\n";
+            } else {
+                for (const Cycle& cycle : cycles)
+                    for (const CycleLeg& leg : cycle.legs)
+                        g_markets[leg.pair].cycle_events = &g_cycles.events;
+                cycle_thread = std::thread(cycleProcess, std::ref(g_markets), std::ref(g_cycles),
+                                           std::cref(cycles), std::ref(kConfig), std::ref(g_opportunity_sink));
+            }
+        }
 
-        std::thread db_thread(dbWriterThread, std::ref(opportunities), std::ref(new_ob));
+        std::thread db_thread(dbWriterThread, std::ref(g_opportunity_sink), std::cref(kConfig));
+
+        // Full-depth recording of the live feeds, on its own thread behind a lock-free queue
+        std::thread record_thread;
+        if (g_recorder)
+            record_thread = std::thread(&BookRecorder::run, g_recorder.get());
         
-        // Connect to exchanges
-        connectToEndpoints(kConfig, connections, orderbooks);
+        // Connect to exchanges, multiplexed over a few shared event loops
+        const LowLatency& ll = kConfig.low_latency;
+        if (!replaying)
+            g_io_pool = std::make_unique<IoPool>(kConfig.io_threads, ll.busy_poll);
+
+        // Pin latency-critical threads; the database writer and recorder are never real-time
+        for (size_t i = 0; i < process_threads.size(); i++) {
+            int core = ll.process_core_count > 0 ? ll.process_cores[i % ll.process_core_count] : -1;
+            applyThreadPolicy(process_threads[i].native_handle(), core, ll.rt_priority, "process");
+        }
+        applyThreadPolicy(db_thread.native_handle(), ll.db_core, 0, "db writer");
+        if (record_thread.joinable())
+            applyThreadPolicy(record_thread.native_handle(), ll.db_core, 0, "recorder");
+        for (int i = 0; g_io_pool && i < g_io_pool->size(); i++) {
+            int core = ll.io_core_count > 0 ? ll.io_cores[i % ll.io_core_count] : -1;
+            applyThreadPolicy(g_io_pool->nativeHandle(i), core, ll.rt_priority, "io");
+        }
+
+        std::thread replay_thread;
+        if (replaying)
+            replay_thread = std::thread(replayThread, std::ref(replay_feed), std::cref(kConfig));
+        else
+            connectToEndpoints(kConfig, connections, g_markets, *g_io_pool, g_recorder.get());
         
-        // Start the command processor in a separate thread
-        std::thread cmd_thread(commandProcessor);
+        // Start the command processor in a separate thread; it may be
+        // blocked on stdin when a signal stops the process, so it is not joined
+        std::thread(commandProcessor).detach();
 
-        if (cmd_thread.joinable()) cmd_thread.join();
-        if (process_thread.joinable()) process_thread.join();
+        // Stop producers before their consumers: feeds, then detectors once
+        // they have processed every queued update, then the writer once it
+        // has written every result
+        g_shutdown.wait(false);
+        closeFeeds();
+        if (g_recorder) g_recorder->stop();
+        g_replay.stop = true;
+        if (replay_thread.joinable()) replay_thread.join();
+        for (int p = 0; p < kTotalPairs; p++)
+            if (kConfig.pairs[p]) queueStop(g_markets[p].events);
+        if (cycle_thread.joinable()) queueStop(g_cycles.events);
+        for (auto& process_thread : process_threads)
+            if (process_thread.joinable()) process_thread.join();
+        if (cycle_thread.joinable()) cycle_thread.join();
+        g_opportunity_sink.close();
         if (db_thread.joinable()) db_thread.join();
+        if (record_thread.joinable()) record_thread.join();
+        if (replaying && kConfig.replay.exit_when_done)
+            displayMetrics();
         
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
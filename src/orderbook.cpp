@@ -1,152 +1,499 @@
 #include "orderbook.hpp"
+#include "depth_kernels.hpp"
+#include "affinity.hpp"
+#include "clock.hpp"
 #include "utils.hpp"
+#include "journal.hpp"
+#include "work_pool.hpp"
+#include <algorithm>
 #include <chrono>
 #include <cstddef>
 #include <cstring>
-#include <semaphore>
+#include <memory>
+#include <string>
+#include <thread>
 #include <vector>
 #include "sqlite3.h"
-#include <fstream>
-#include <iomanip>
+#include <iostream>
 #include <array>
 
-// Forward declaration of global variables from main.cpp
-extern struct Metrics g_metrics;
+/// @brief Widest depth kernel supported by this CPU, resolved once at startup
+static const DepthKernel kDepthKernel = selectDepthKernel();
+
+/// @brief 128-bit integer for fee-scaled profits and price comparisons
+using Wide = __int128;
+
+/**
+ * Implementation notes:
+ * - Dispatches to the AVX-512/AVX2/scalar kernel picked at startup
+ * - Each side stops at the first level that fills max_lots
+ * - Notional is bounded by max_lots times the side's highest price (last
+ *   ask, first bid), so one overflow check per side covers every level used
+ */
+bool computeDepth(L2OrderBook& ob, Lots max_lots)
+{
+    bool fits = true;
+    Notional bound;
+
+    Ticks ask_high = ob.askSize > 0 ? ob.askPrice[ob.askSize - 1] : 0;
+    if (__builtin_mul_overflow(max_lots, ask_high, &bound)) {
+        ob.askDepth = 0;
+        fits = false;
+    } else {
+        ob.askDepth = kDepthKernel(ob.askQuantity, ob.askPrice, ob.askSize,
+                                   max_lots, ob.askCumQty, ob.askCumCost);
+    }
+
+    Ticks bid_high = ob.bidSize > 0 ? ob.bidPrice[0] : 0;
+    if (__builtin_mul_overflow(max_lots, bid_high, &bound)) {
+        ob.bidDepth = 0;
+        fits = false;
+    } else {
+        ob.bidDepth = kDepthKernel(ob.bidQuantity, ob.bidPrice, ob.bidSize,
+                                   max_lots, ob.bidCumQty, ob.bidCumCost);
+    }
+    return fits;
+}
+
+/**
+ * Implementation notes:
+ * - Two-pointer walk over the union of ask and bid cumulative quantities;
+ *   each step is a segment priced at one ask level and one bid level
+ * - Cost and revenue at a breakpoint come from the prefix arrays plus a
+ *   partial level, so they are exact integers
+ * - Profits are kept multiplied by kFeeDen in 128-bit to stay exact
+ * - Stops at the first segment whose marginal profit is not positive,
+ *   unless a curve was requested, in which case the walk runs to the end
+ */
+bool solveBestSize(const L2OrderBook& buy, const L2OrderBook& sell, int64_t fee,
+                   double min_profit, Opportunity& best,
+                   ProfitPoint* curve, int* curve_n)
+{
+    const int64_t fee_mult = kFeeDen + fee;
+    const int buy_n = buy.askDepth, sell_n = sell.bidDepth;
+    const double qty_unit = static_cast<double>(kPow10[buy.scale.qty_decimals]);
+    const double profit_unit = static_cast<double>(kPow10[buy.scale.price_decimals + buy.scale.qty_decimals]) * kFeeDen;
+
+    Lots best_q = 0;
+    Notional best_cost = 0, best_rev = 0;
+    Wide best_profit = 0;
+    int best_bi = 0, best_si = 0;
+    bool rising = true;
+    int n = 0;
+
+    int bi = 0, si = 0;
+    while (bi < buy_n && si < sell_n) {
+        Lots buy_q = buy.askCumQty[bi], sell_q = sell.bidCumQty[si];
+        Lots q = buy_q < sell_q ? buy_q : sell_q;
+
+        if (Wide(sell.bidPrice[si]) * kFeeDen <= Wide(buy.askPrice[bi]) * fee_mult) {
+            rising = false;
+            if (!curve)
+                break;
+        }
+
+        Lots prev_bq = bi > 0 ? buy.askCumQty[bi - 1] : 0;
+        Notional prev_bc = bi > 0 ? buy.askCumCost[bi - 1] : 0;
+        Lots prev_sq = si > 0 ? sell.bidCumQty[si - 1] : 0;
+        Notional prev_sc = si > 0 ? sell.bidCumCost[si - 1] : 0;
+        Notional cost = q == buy_q ? buy.askCumCost[bi] : prev_bc + (q - prev_bq) * buy.askPrice[bi];
+        Notional rev = q == sell_q ? sell.bidCumCost[si] : prev_sc + (q - prev_sq) * sell.bidPrice[si];
+        Wide profit = Wide(rev) * kFeeDen - Wide(cost) * fee_mult;
+
+        if (rising) {
+            best_q = q;
+            best_cost = cost;
+            best_rev = rev;
+            best_profit = profit;
+            best_bi = bi;
+            best_si = si;
+        }
+        if (curve)
+            curve[n++] = {q / qty_unit, static_cast<double>(profit) / profit_unit};
+
+        bi += buy_q <= q;
+        si += sell_q <= q;
+    }
+    if (curve_n)
+        *curve_n = n;
+
+    double net_profit = static_cast<double>(best_profit) / profit_unit;
+    if (best_q <= 0 || net_profit < min_profit)
+        return false;
+
+    best.buy_levels = best_bi + 1;
+    best.sell_levels = best_si + 1;
+    best.buy_vwap = toPrice(buy, 1) * best_cost / best_q;
+    best.sell_vwap = toPrice(buy, 1) * best_rev / best_q;
+    best.profit_pct = (best.sell_vwap - best.buy_vwap) / best.buy_vwap * 100.0 - fee * 100.0 / kFeeDen;
+    best.order_size = best_q / qty_unit;
+    best.net_profit = net_profit;
+    return true;
+}
+
+namespace {
+
+/// @brief Evaluates one exchange pair into a lane, see detectPairs()
+inline void detectPair(const L2OrderBook* books, const ExchangePair& ep, double min_profit,
+                       std::chrono::high_resolution_clock::time_point received, DetectLane& lane)
+{
+    const L2OrderBook& lbuy = books[ep.buy];
+    const L2OrderBook& lsell = books[ep.sell];
+    bool hopeless = Wide(lsell.bidPrice[0]) * kFeeDen <= Wide(lbuy.askPrice[0]) * (kFeeDen + ep.fee);
+    if ((min_profit > 0.0) & hopeless) {
+        ++lane.pruned;
+        return;
+    }
+
+    // One record per exchange pair: the size that maximizes net profit
+    Opportunity opp;
+    if (!solveBestSize(lbuy, lsell, ep.fee, min_profit, opp))
+        return;
+
+    auto now = DetectionClock::now();
+    auto latency = now < received ? 0 : std::chrono::duration_cast<std::chrono::microseconds>(
+        now - received).count();
+    opp.buy_exchange = ep.buy;
+    opp.sell_exchange = ep.sell;
+    opp.detection_latency_us = static_cast<double>(latency);
+    opp.detection_time = now;
+    lane.found.push_back(opp);
+}
+
+}  // namespace
+
+/**
+ * Implementation notes:
+ * - Small batches run inline on lane 0: waking helpers costs more than a
+ *   few O(L) merges
+ * - Each participant appends to its own lane, so the loop shares nothing
+ *   but the pool's range words
+ * - Lanes are concatenated and sorted by (buy, sell), which is the order
+ *   the serial loop produces
+ */
+uint64_t detectPairs(const L2OrderBook* books, const ExchangePair* pairs, int count, double min_profit,
+                     std::chrono::high_resolution_clock::time_point received,
+                     WorkStealingPool* pool, int min_parallel,
+                     std::vector<DetectLane>& lanes, std::vector<Opportunity>& out)
+{
+    out.clear();
+    const bool parallel = pool && pool->size() > 1 && count >= min_parallel;
+    const int used = parallel ? pool->size() : 1;
+    for (int w = 0; w < used; ++w) {
+        lanes[w].found.clear();
+        lanes[w].pruned = 0;
+    }
+
+    if (parallel) {
+        pool->parallelFor(count, [&](int index, int worker) {
+            detectPair(books, pairs[index], min_profit, received, lanes[worker]);
+        });
+    } else {
+        for (int k = 0; k < count; ++k)
+            detectPair(books, pairs[k], min_profit, received, lanes[0]);
+    }
+
+    uint64_t pruned = 0;
+    for (int w = 0; w < used; ++w) {
+        out.insert(out.end(), lanes[w].found.begin(), lanes[w].found.end());
+        pruned += lanes[w].pruned;
+    }
+    if (parallel) {
+        std::sort(out.begin(), out.end(), [](const Opportunity& a, const Opportunity& b) {
+            return a.buy_exchange != b.buy_exchange ? a.buy_exchange < b.buy_exchange
+                                                    : a.sell_exchange < b.sell_exchange;
+        });
+    }
+    return pruned;
+}
+
+uint64_t selectPairs(const L2OrderBook* books, int updated, const config& cfg,
+                     const int64_t (*fees)[kTotalExchanges], const bool* stale,
+                     std::vector<ExchangePair>& out)
+{
+    out.clear();
+    uint64_t skipped = 0;
+
+    for (int i = 0; i < kTotalExchanges; ++i) {
+        if (!cfg.exchanges[i])
+            continue;
+        if (books[i].askDepth == 0)
+            continue;
+
+        for (int j = 0; j < kTotalExchanges; ++j) {
+            if (!cfg.exchanges[j])
+                continue;
+            if (cfg.incremental && i != updated && j != updated)
+                continue;
+            if (books[j].bidDepth == 0)
+                continue;
+            if (stale[i] | stale[j]) {
+                ++skipped;
+                continue;
+            }
+            out.push_back({i, j, fees[i][j]});
+        }
+    }
+    return skipped;
+}
 
 /**
  * @brief Main processing function for arbitrage detection
  * 
  * Implementation details:
- * - Uses semaphore synchronization for thread safety
- * - Maintains local copy of orderbooks to prevent data races
- * - Calculates VWAP using cumulative quantities and costs
+ * - Waits on the book event queue; each event names the updated exchange
+ * - Maintains local copy of orderbooks, read torn-free through the seqlock
+ * - Calculates VWAP by merging the cumulative quantities and costs each
+ *   book carries, so no prefix sums are rebuilt here
  * - Optimizes memory access with aligned data structures
  * - Processes opportunities in O(n) time per orderbook update
+ * - In incremental mode only evaluates exchange pairs that include the
+ *   updated book, O(E*L) instead of O(E^2*L) per update; all other pairs
+ *   were already evaluated against the same books on an earlier update
+ * - Rejects exchange pairs from top of book alone when the best bid does not
+ *   beat the best ask after both fees; VWAPs only worsen with depth, so no
+ *   level sweep could clear a positive min_profit
+ * - All comparisons are on integer ticks, cross-multiplied by the fee factor
+ * - Book ages are taken once per event from each book's socket receive
+ *   time; a quote that old has likely been pulled, so exchange pairs with
+ *   a stale side are skipped before any depth is walked
+ * - Surviving exchange pairs are collected first and evaluated by
+ *   detectPairs(), on the detection pool when cfg.detect_threads is set and
+ *   the batch reaches cfg.detect_min_pairs
  * 
  * Algorithm flow:
- * 1. Wait for new orderbook data
- * 2. Copy and process the updated orderbook
- * 3. Calculate VWAPs for both buy and sell sides
- * 4. Detect arbitrage opportunities based on profit threshold
- * 5. Record opportunities with timing information
+ * 1. Pop the next book event
+ * 2. Copy the updated orderbook, skipping it if already superseded
+ * 3. Age every book and mark those past their venue's limit as stale
+ * 4. Collect the exchange pairs with depth on both sides and fresh books
+ *    (selectPairs(), shared with the backtester)
+ * 5. Merge buy and sell prefixes to find the profit-maximizing size
+ * 6. Emit at most one opportunity per exchange pair if it clears the threshold
+ * 7. Record opportunities with timing measured from the event's receive time
+ *    and the age of both books
+ * 8. Hand the opportunities and the book's top of book to the sink
  * 
- * @param orderbooks Vector of orderbooks from different exchanges
- * @param cfg Trading configuration parameters
- * @param out_opps Vector to store detected opportunities
- * @param new_ob Reference to store the latest orderbook update
+ * Only this pair's books, queue, metrics and sink rings are touched, so
+ * workers of different pairs share nothing. All buffers are sized up
+ * front; no allocation happens per update.
  */
-void process(std::vector<L2OrderBook>& orderbooks, config& cfg, std::vector<Opportunity>& out_opps, L2OrderBook& new_ob)
+void process(int pair, PairBooks& market, config& cfg, OpportunitySink& sink)
 {
-    int num_orderboks = orderbooks.size();
-    double buy_qty[kMaxSize], buy_cost[kMaxSize];
-    double sell_qty[kMaxSize], sell_cost[kMaxSize];
-    std::vector<L2OrderBook> local_books(num_orderboks);
+    std::vector<L2OrderBook> local_books(kTotalExchanges);
+    std::vector<Opportunity> out_opps;
+    std::vector<ExchangePair> candidates;
+    candidates.reserve(kTotalExchanges * kTotalExchanges);
+    Metrics& metrics = market.metrics;
+    BookEvent ev;
+
+    // Combined fees of each exchange pair in parts per kFeeDen
+    int64_t fees[kTotalExchanges][kTotalExchanges];
+    for (int i = 0; i < kTotalExchanges; ++i)
+        for (int j = 0; j < kTotalExchanges; ++j)
+            fees[i][j] = feeUnits(cfg.fees[i] + cfg.fees[j]);
+    const bool busy_poll = cfg.low_latency.busy_poll;
+
+    // No update has more exchange pairs than kTotalExchanges^2, so below
+    // that threshold a pool could never be handed a loop
+    std::unique_ptr<WorkStealingPool> pool;
+    if (cfg.detect_threads > 0 && kTotalExchanges * kTotalExchanges >= cfg.detect_min_pairs) {
+        // Helpers only spin, and only run real-time, on cores of their own;
+        // unpinned, they sleep between loops under the default scheduler
+        const LowLatency& ll = cfg.low_latency;
+        const bool pinned = ll.detect_core_count > 0;
+        pool = std::make_unique<WorkStealingPool>(cfg.detect_threads, busy_poll && pinned);
+        int slot = 0;
+        for (int p = 0; p < pair; ++p)
+            slot += cfg.pairs[p];
+        for (int h = 0; pinned && h < cfg.detect_threads; ++h) {
+            int core = ll.detect_cores[(slot * cfg.detect_threads + h) % ll.detect_core_count];
+            applyThreadPolicy(pool->nativeHandle(h), core, ll.rt_priority, "detect");
+        }
+    }
+    std::vector<DetectLane> lanes(pool ? pool->size() : 1);
+
+    // Sized for the most exchange pairs one update can produce, so the
+    // loop below never allocates
+    out_opps.reserve(kTotalExchanges * kTotalExchanges);
+    for (DetectLane& lane : lanes)
+        lane.found.reserve(kTotalExchanges * kTotalExchanges);
     
     while (true) {
-        sem.acquire();
-        g_metrics.updates_processed++;
-        out_opps.clear();
-        
-        int count_new = 0;
-        for (size_t i = 0; i < kTotalExchanges; i++) {
-            if(orderbooks[i].newData) {
-                memcpy(&local_books[i], &orderbooks[i], sizeof(L2OrderBook));
-                orderbooks[i].newData = false;
-                count_new = i;
-                break;
-            }
+        if (busy_poll)
+            market.events.spinPop(ev);
+        else
+            market.events.pop(ev);
+        if (ev.exchange == kStopEvent)
+            return;
+        int updated = ev.exchange;
+        if (market.books[updated].read(local_books[updated]) != ev.sequence) {
+            // A newer version of this book has its own event queued behind us
+            metrics.updates_superseded++;
+            continue;
         }
 
-        int buy_n = 0, sell_n = 0;
-        out_opps.clear();
-
+        auto aged_at = DetectionClock::now();
+        int64_t age_us[kTotalExchanges];
+        bool stale[kTotalExchanges];
         for (int i = 0; i < kTotalExchanges; ++i) {
-            if (!cfg.exchanges[i])
-                continue;
-            const auto& lbuy = local_books[i];
-            if (lbuy.askSize == 0)
-                continue;
+            age_us[i] = bookAgeUs(local_books[i], aged_at);
+            stale[i] = isStale(age_us[i], cfg.max_book_age_ms[i]);
+        }
 
-            // Build buy cumulatives up to actual askSize
-            {
-                double total_q = 0.0, total_c = 0.0;
-                buy_n = 0;
-                for (int lvl = 0; lvl < lbuy.askSize && total_q < cfg.max_order_size; ++lvl) {
-                    double avail = std::min(lbuy.askQuantity[lvl], cfg.max_order_size - total_q);
-                    total_q += avail;
-                    total_c += avail * lbuy.askPrice[lvl];
-                    buy_qty[buy_n] = total_q;
-                    buy_cost[buy_n] = total_c;
-                    ++buy_n;
-                }
-                if (buy_n == 0)
-                    continue;
-            }
+        uint64_t skipped = selectPairs(local_books.data(), updated, cfg, fees, stale, candidates);
+        uint64_t pruned = detectPairs(local_books.data(), candidates.data(),
+                                      static_cast<int>(candidates.size()), cfg.min_profit, ev.t,
+                                      pool.get(), cfg.detect_min_pairs, lanes, out_opps);
+        for (Opportunity& opp : out_opps) {
+            opp.pair = pair;
+            opp.buy_book_age_us = static_cast<double>(age_us[opp.buy_exchange]);
+            opp.sell_book_age_us = static_cast<double>(age_us[opp.sell_exchange]);
+            metrics.opportunities_found++;
+            metrics.updateLatency(static_cast<uint64_t>(opp.detection_latency_us));
+        }
+        metrics.pairs_pruned += pruned;
+        metrics.stale_skipped += skipped;
 
-            for (int j = 0; j < kTotalExchanges; ++j) {
-                if (!cfg.exchanges[j])
-                    continue;
-                const auto& lsell = local_books[j];
-                if (lsell.bidSize == 0)
-                    continue;
-
-                // Build sell cumulatives up to actual bidSize
-                {
-                    double total_q = 0.0, total_c = 0.0;
-                    sell_n = 0;
-                    for (int lvl = 0; lvl < lsell.bidSize && total_q < cfg.max_order_size; ++lvl) {
-                        double avail = std::min(lsell.bidQuantity[lvl], cfg.max_order_size - total_q);
-                        total_q += avail;
-                        total_c += avail * lsell.bidPrice[lvl];
-                        sell_qty[sell_n] = total_q;
-                        sell_cost[sell_n] = total_c;
-                        ++sell_n;
-                    }
-                    if (sell_n == 0)
-                        continue;
-                }
-                
-                int bi = 0, si = 0;
-                while (bi < buy_n && si < sell_n) {
-                    double common_qty = (buy_qty[bi] < sell_qty[si] ? buy_qty[bi] : sell_qty[si]);
-                    double buy_vwap = buy_cost[bi] / buy_qty[bi];
-                    double sell_vwap = sell_cost[si] / sell_qty[si];
-                    double gross_pct = (sell_vwap - buy_vwap) / buy_vwap * 100.0;
-                    double net_pct = gross_pct - (cfg.fees[i] + cfg.fees[j]);
-                    double net_profit = net_pct * common_qty * buy_vwap / 100.0;
-
-                    if (net_profit >= cfg.min_profit) {
-                        auto now = std::chrono::high_resolution_clock::now();
-                        if (local_books[count_new].t.time_since_epoch().count() <= 0) continue;
-                        if(now < local_books[count_new].t) continue;
-                        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
-                            now - local_books[count_new].t).count();
-                        
-                        out_opps.push_back({
-                            i, j,
-                            bi + 1,
-                            si + 1,
-                            buy_vwap,
-                            sell_vwap,
-                            net_pct,
-                            common_qty,
-                            static_cast<double>(latency),
-                            now
-                        });
-
-                        g_metrics.opportunities_found++;
-                        g_metrics.updateLatency(static_cast<uint64_t>(latency));
-                    }
-                    
-                    if (buy_qty[bi] < sell_qty[si])
-                        ++bi;
-                    else
-                        ++si;
-                }
-            }
+        const L2OrderBook& ob = local_books[updated];
+        BookSummary summary{updated, pair, ob.t, 0.0, 0.0, 0.0, 0.0};
+        if (ob.askSize > 0) {
+            summary.topAsk = toPrice(ob, ob.askPrice[0]);
+            summary.topAskQty = toQuantity(ob, ob.askQuantity[0]);
+        }
+        if (ob.bidSize > 0) {
+            summary.topBid = toPrice(ob, ob.bidPrice[0]);
+            summary.topBidQty = toQuantity(ob, ob.bidQuantity[0]);
         }
-        memcpy(&new_ob, &local_books[count_new], sizeof(L2OrderBook));
-        sem1.release();
+        sink.publish(pair, out_opps, summary);
+        // Counted once fully handled, which replay waits on
+        metrics.updates_processed++;
+    }
+}
+
+bool ingestBook(int exchange, int pair, L2OrderBook& ob, Lots max_lots, PublishedBook& slot,
+                BookEventQueue& events, BookEventQueue* cycle_events)
+{
+    bool fits = computeDepth(ob, max_lots);
+    uint64_t sequence = slot.publish(ob);
+    events.tryPush({exchange, pair, sequence, ob.rxTime});
+    if (cycle_events)
+        cycle_events->tryPush({exchange, pair, sequence, ob.rxTime});
+    return fits;
+}
+
+void queueStop(BookEventQueue& events)
+{
+    while (!events.tryPush({kStopEvent, 0, 0, {}}))
+        std::this_thread::yield();
+}
+
+/**
+ * Implementation notes:
+ * - Each record is copied into preallocated ring storage; a full ring
+ *   drops the record and counts it rather than wait for the writer
+ * - One counter bump and wake-up per update, however many records it had
+ */
+void OpportunitySink::publish(int pair, const std::vector<Opportunity>& opps, const BookSummary& summary)
+{
+    for (const Opportunity& opp : opps)
+        opps_[pair].tryPush(opp);
+    summaries_[pair].tryPush(summary);
+    published_.fetch_add(1, std::memory_order_release);
+    published_.notify_one();
+}
+
+void OpportunitySink::publishCycles(const std::vector<CycleOpportunity>& cycles)
+{
+    for (const CycleOpportunity& cycle : cycles)
+        cycles_.tryPush(cycle);
+    published_.fetch_add(1, std::memory_order_release);
+    published_.notify_one();
+}
+
+void OpportunitySink::close()
+{
+    closed_.store(true, std::memory_order_release);
+    published_.fetch_add(1, std::memory_order_release);
+    published_.notify_one();
+}
+
+uint64_t OpportunitySink::droppedOpportunities() const
+{
+    uint64_t dropped = 0;
+    for (const auto& ring : opps_)
+        dropped += ring.dropped();
+    return dropped;
+}
+
+uint64_t OpportunitySink::droppedSummaries() const
+{
+    uint64_t dropped = 0;
+    for (const auto& ring : summaries_)
+        dropped += ring.dropped();
+    return dropped;
+}
+
+bool OpportunitySink::collect(std::vector<Opportunity>& opps, std::vector<BookSummary>& summaries,
+                              std::vector<CycleOpportunity>& cycles)
+{
+    Opportunity opp;
+    BookSummary summary;
+    CycleOpportunity cycle;
+    bool any = false;
+    for (int p = 0; p < kTotalPairs; ++p) {
+        while (opps_[p].tryPop(opp)) {
+            opps.push_back(opp);
+            any = true;
+        }
+        while (summaries_[p].tryPop(summary)) {
+            summaries.push_back(summary);
+            any = true;
+        }
+    }
+    while (cycles_.tryPop(cycle)) {
+        cycles.push_back(cycle);
+        any = true;
+    }
+    return any;
+}
+
+/**
+ * Implementation notes:
+ * - The publish counter is read before the rings are checked, so a publish
+ *   landing after an empty check changes it and the wait returns at once
+ * - Without a deadline the writer sleeps on the counter until the next
+ *   publish; with one it naps in kDeadlinePollInterval steps, since an
+ *   atomic wait cannot time out
+ * - The closed flag is read before the rings too, so results published
+ *   ahead of close() are collected before the end is reported; close()
+ *   bumps the counter to wake a sleeping writer
+ */
+bool OpportunitySink::drain(std::vector<Opportunity>& opps, std::vector<BookSummary>& summaries,
+                            std::vector<CycleOpportunity>& cycles, bool busy_poll,
+                            std::chrono::steady_clock::time_point deadline)
+{
+    opps.clear();
+    summaries.clear();
+    cycles.clear();
+    const bool forever = deadline == std::chrono::steady_clock::time_point::max();
+    while (true) {
+        bool closing = closed();
+        uint64_t seen = published_.load(std::memory_order_acquire);
+        if (collect(opps, summaries, cycles))
+            return true;
+        if (closing)
+            return false;
+
+        auto now = std::chrono::steady_clock::now();
+        if (!forever && now >= deadline)
+            return false;
+        if (busy_poll)
+            cpuRelax();
+        else if (forever)
+            published_.wait(seen, std::memory_order_acquire);
+        else
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                deadline - now, kDeadlinePollInterval));
     }
 }
 
@@ -155,29 +502,41 @@ void process(std::vector<L2OrderBook>& orderbooks, config& cfg, std::vector<Oppo
  * 
  * Implementation details:
  * - Uses SQLite for orderbook summary storage
- * - Writes opportunities to text file for analysis
- * - Uses transactions for atomic database updates
- * - Maintains continuous operation through semaphore synchronization
+ * - Appends pair and triangular opportunities to the binary journal as
+ *   fixed-size records; rendering them as text is left to readers
+ * - The insert statement is prepared once for the life of the thread
+ * - Rows accumulate in one open transaction, committed once it holds
+ *   cfg.db.batch_rows rows or has been open cfg.db.batch_ms; a commit is
+ *   due at most batch_ms after its first row even if no more arrive
+ * - WAL journal with a configurable synchronous level: with "normal",
+ *   commits append to the log without an fsync
+ * - Drains the sink rings of every pair worker and the cycle detector
+ * - Rows are tagged with exchange and pair; databases created before
+ *   multi-pair support get the two columns added on open
+ * - Stops when drain() reports the sink closed and empty, which only
+ *   happens after every publisher has returned, so nothing is left behind
  * 
  * Data stored:
  * - Orderbook: top prices, quantities, spreads, and imbalances
- * - Opportunities: full details including profit and timing information
+ * - Opportunities: full details including profit and timing information,
+ *   readable with arb_dump or the CLI
  * 
- * @param opportunities Vector of detected arbitrage opportunities
- * @param ob Latest orderbook state
+ * @param sink Results published by the pair workers
+ * @param cfg Trading configuration; uses cfg.db and cfg.low_latency.busy_poll
  * @return -1 on error, never returns on success
  */
-int dbWriterThread(std::vector<Opportunity>& opportunities, L2OrderBook& ob) {
+int dbWriterThread(OpportunitySink& sink, const config& cfg) {
     sqlite3* db;
     if (sqlite3_open(kDbStoragePath.c_str(), &db)) {
         std::cerr << "DB open failed\n";
         return -1;
     }
 
-    // Open opportunities file for append
-    std::ofstream opps_file(kOppStoragePath, std::ios::app);
-    if (!opps_file) {
-        std::cerr << "Failed to open opportunities.txt\n";
+    JournalWriter journal;
+    try {
+        journal.open(kJournalPath);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
         sqlite3_close(db);
         return -1;
     }
@@ -192,7 +551,9 @@ int dbWriterThread(std::vector<Opportunity>& opportunities, L2OrderBook& ob) {
             topBidQty REAL,
             midPrice REAL,
             spread REAL,
-            imbalance REAL
+            imbalance REAL,
+            exchange TEXT,
+            pair TEXT
         );
     )";
 
@@ -203,75 +564,130 @@ int dbWriterThread(std::vector<Opportunity>& opportunities, L2OrderBook& ob) {
         sqlite3_close(db);
         return -1;
     }
+    // Tables created before summaries carried their exchange and pair lack
+    // those columns; only the missing ones are added
+    std::vector<std::string> columns;
+    sqlite3_stmt* table_info;
+    if (sqlite3_prepare_v2(db, "PRAGMA table_info(OrderBook);", -1, &table_info, nullptr) != SQLITE_OK) {
+        std::cerr << "Reading table columns failed: " << sqlite3_errmsg(db) << "\n";
+        sqlite3_close(db);
+        return -1;
+    }
+    while (sqlite3_step(table_info) == SQLITE_ROW) {
+        if (const unsigned char* name = sqlite3_column_text(table_info, 1))
+            columns.emplace_back(reinterpret_cast<const char*>(name));
+    }
+    sqlite3_finalize(table_info);
+    for (const char* column : {"exchange", "pair"}) {
+        if (std::find(columns.begin(), columns.end(), column) != columns.end())
+            continue;
+        std::string alter = "ALTER TABLE OrderBook ADD COLUMN " + std::string(column) + " TEXT;";
+        if (sqlite3_exec(db, alter.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            std::cerr << "Adding column " << column << " failed: " << errMsg << "\n";
+            sqlite3_free(errMsg);
+            sqlite3_close(db);
+            return -1;
+        }
+    }
+
+    if (sqlite3_exec(db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "WAL mode failed: " << errMsg << "\n";
+        sqlite3_free(errMsg);
+    }
+    std::string synchronous = "PRAGMA synchronous=" + std::string(kDbSynchronousLevels[cfg.db.synchronous]) + ";";
+    if (sqlite3_exec(db, synchronous.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "Setting synchronous failed: " << errMsg << "\n";
+        sqlite3_free(errMsg);
+    }
+
+    const char* sql = R"(
+        INSERT INTO OrderBook (
+            timestamp, topAsk, topAskQty, topBid, topBidQty, midPrice, spread, imbalance,
+            exchange, pair
+        ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+    )";
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Prepare failed: " << sqlite3_errmsg(db) << "\n";
+        sqlite3_close(db);
+        return -1;
+    }
+
+    const bool busy_poll = cfg.low_latency.busy_poll;
+    const auto batch_window = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::milli>(cfg.db.batch_ms));
+    auto commit_by = std::chrono::steady_clock::time_point::max();
+    int batch_rows = 0;
+
+    auto commit = [&] {
+        if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            std::cerr << "Commit failed: " << errMsg << "\n";
+            sqlite3_free(errMsg);
+        }
+        batch_rows = 0;
+        commit_by = std::chrono::steady_clock::time_point::max();
+    };
 
     std::vector<Opportunity> local_opps;
+    std::vector<BookSummary> summaries;
+    std::vector<CycleOpportunity> cycles;
 
     while (true) {
-        sem1.acquire();
-
-        local_opps = opportunities;
-
-        for (const auto& opp : local_opps) {
-            opps_file << "\nArbitrage Opportunity:\n"
-                     << "Buy on " << kExchanges[opp.buy_exchange] 
-                     << " at " << std::fixed << std::setprecision(2) << opp.buy_vwap
-                     << " using " << opp.buy_levels << " levels\n"
-                     << "Sell on " << kExchanges[opp.sell_exchange]
-                     << " at " << opp.sell_vwap
-                     << " using " << opp.sell_levels << " levels\n"
-                     << "Profit: " << std::setprecision(3) << opp.profit_pct << "%\n"
-                     << "Order Size: " << std::setprecision(6) << opp.order_size << " BTC\n"
-                     << "Market Impact: " << (opp.buy_levels + opp.sell_levels) << " levels deep\n"
-                     << "Detection Latency: " << std::fixed << std::setprecision(2) 
-                     << opp.detection_latency_us << " μs\n"
-                     << std::string(50, '-') << "\n";
+        if (!sink.drain(local_opps, summaries, cycles, busy_poll, commit_by)) {
+            if (sink.closed())
+                break;
+            // Nothing new before the open batch came due
+            commit();
+            continue;
         }
-        opps_file.flush();
 
-        const char* sql = R"(
-            INSERT INTO OrderBook (
-                timestamp, topAsk, topAskQty, topBid, topBidQty, midPrice, spread, imbalance
-            ) VALUES (?, ?, ?, ?, ?, ?, ?, ?)
-        )";
+        for (const auto& opp : local_opps)
+            journal.append(toJournalRecord(opp));
+        for (const auto& cycle : cycles)
+            journal.append(toJournalRecord(cycle));
 
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            std::cerr << "Prepare failed: " << sqlite3_errmsg(db) << "\n";
-            return -1;
-        }
-    
-        sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
-    
-        double topAsk = ob.askPrice[0];
-        double topAskQty = ob.askQuantity[0];
-        double topBid = ob.bidPrice[0];
-        double topBidQty = ob.bidQuantity[0];
-    
-        double mid = (topAsk + topBid) / 2.0;
-        double spread = topAsk - topBid;
-        double imbalance = (topBidQty - topAskQty) / (topBidQty + topAskQty + 1e-9);
-    
-        int idx = 1;
-        auto ts = std::chrono::duration_cast<std::chrono::microseconds>(ob.t.time_since_epoch()).count();
-    
-        sqlite3_bind_int64(stmt, idx++, ts);
-        sqlite3_bind_double(stmt, idx++, topAsk);
-        sqlite3_bind_double(stmt, idx++, topAskQty);
-        sqlite3_bind_double(stmt, idx++, topBid);
-        sqlite3_bind_double(stmt, idx++, topBidQty);
-        sqlite3_bind_double(stmt, idx++, mid);
-        sqlite3_bind_double(stmt, idx++, spread);
-        sqlite3_bind_double(stmt, idx++, imbalance);
-    
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            std::cerr << "Insert failed: " << sqlite3_errmsg(db) << "\n";
+        for (const auto& summary : summaries) {
+            if (batch_rows == 0) {
+                sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
+                commit_by = std::chrono::steady_clock::now() + batch_window;
+            }
+
+            double mid = (summary.topAsk + summary.topBid) / 2.0;
+            double spread = summary.topAsk - summary.topBid;
+            double imbalance = (summary.topBidQty - summary.topAskQty) / (summary.topBidQty + summary.topAskQty + 1e-9);
+
+            int idx = 1;
+            auto ts = std::chrono::duration_cast<std::chrono::microseconds>(summary.t.time_since_epoch()).count();
+            std::string_view exchange = kExchanges[summary.exchange];
+            std::string_view pair = kPairs[summary.pair];
+
+            sqlite3_bind_int64(stmt, idx++, ts);
+            sqlite3_bind_double(stmt, idx++, summary.topAsk);
+            sqlite3_bind_double(stmt, idx++, summary.topAskQty);
+            sqlite3_bind_double(stmt, idx++, summary.topBid);
+            sqlite3_bind_double(stmt, idx++, summary.topBidQty);
+            sqlite3_bind_double(stmt, idx++, mid);
+            sqlite3_bind_double(stmt, idx++, spread);
+            sqlite3_bind_double(stmt, idx++, imbalance);
+            sqlite3_bind_text(stmt, idx++, exchange.data(), static_cast<int>(exchange.size()), SQLITE_STATIC);
+            sqlite3_bind_text(stmt, idx++, pair.data(), static_cast<int>(pair.size()), SQLITE_STATIC);
+
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                std::cerr << "Insert failed: " << sqlite3_errmsg(db) << "\n";
+            }
+            sqlite3_reset(stmt);
+
+            if (++batch_rows >= cfg.db.batch_rows)
+                commit();
         }
-    
-        sqlite3_reset(stmt);
-        sqlite3_finalize(stmt);
-        sqlite3_exec(db, "END TRANSACTION;", nullptr, nullptr, nullptr);
+        if (batch_rows > 0 && std::chrono::steady_clock::now() >= commit_by)
+            commit();
     }
 
-    opps_file.close();
+    if (batch_rows > 0)
+        commit();
+    sqlite3_finalize(stmt);
     sqlite3_close(db);
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,479 @@
+#include "recorder.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+/// @brief Nanoseconds since the epoch of a time point
+int64_t sinceEpochNs(std::chrono::high_resolution_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+/// @brief Time point of nanoseconds since the epoch
+std::chrono::high_resolution_clock::time_point fromEpochNs(int64_t ns) {
+    return std::chrono::high_resolution_clock::time_point(
+        std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::nanoseconds(ns)));
+}
+
+/// @brief Copies a name into a fixed header slot, NUL-terminated
+void copyName(char (&slot)[kRecordingNameSize], std::string_view name) {
+    size_t n = std::min(name.size(), sizeof(slot) - 1);
+    std::memcpy(slot, name.data(), n);
+    slot[n] = '\0';
+}
+
+/// @brief Maps signed values to unsigned so small magnitudes stay small
+uint64_t zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+/// @brief Inverse of zigzag()
+int64_t unzigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+/// @brief Appends v in LEB128 form, seven bits per byte
+void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+/// @brief Bounds-checked read position in one encoded column
+struct Cursor {
+    const uint8_t* p;    ///< Next byte
+    const uint8_t* end;  ///< End of the column
+    bool ok = true;      ///< Cleared on reading past the end or an overlong varint
+
+    uint8_t byte() {
+        if (p == end) {
+            ok = false;
+            return 0;
+        }
+        return *p++;
+    }
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return v;
+        }
+        ok = false;
+        return 0;
+    }
+
+    int64_t svarint() { return unzigzag(varint()); }
+};
+
+/**
+ * @brief Largest power of ten, up to 10^18, dividing every value given
+ * @param exp Current exponent, lowered as needed
+ * @param values Values to check
+ * @param count Number of values
+ */
+void narrowExp(int& exp, const int64_t* values, int count) {
+    for (int i = 0; i < count && exp > 0; i++)
+        while (exp > 0 && values[i] % kPow10[exp] != 0)
+            exp--;
+}
+
+/// @brief Previous top of book of each (exchange, pair, side) in a chunk
+using TopState = int64_t[kRecordingMaxNames][kRecordingMaxNames][2];
+
+/// @brief Previous book of each (exchange, pair) in a chunk, nullptr before the first
+using PrevState = const RecordedBook*[kRecordingMaxNames][kRecordingMaxNames];
+
+/**
+ * @brief Finds a price on one side of the previous book
+ *
+ * Prices are looked up in side order, so one cursor walks the previous
+ * side once per book.
+ *
+ * @param price Price to find
+ * @param prices Prices of the previous side, ascending for asks and descending for bids
+ * @param size Levels of the previous side
+ * @param ask Whether the side is the ask side
+ * @param j Merge cursor into prices, advanced past smaller (asks) or larger (bids) prices
+ * @return Level of price in the previous side, -1 if absent
+ */
+int findLevel(Ticks price, const Ticks* prices, int size, bool ask, int& j) {
+    while (j < size && (ask ? prices[j] < price : prices[j] > price))
+        j++;
+    return j < size && prices[j] == price ? j : -1;
+}
+
+/**
+ * @brief Encodes the quantities of one side
+ *
+ * A level whose price and quantity are unchanged from the previous book
+ * of the stream is written as 0, any other quantity q as q / div + 1.
+ * Quantities are never negative.
+ */
+void putQuantities(std::vector<uint8_t>& out, const Ticks* price, const Lots* qty, int size,
+                   const Ticks* prev_price, const Lots* prev_qty, int prev_size, bool ask, int64_t div) {
+    int j = 0;
+    for (int i = 0; i < size; i++) {
+        int k = findLevel(price[i], prev_price, prev_size, ask, j);
+        putVarint(out, k >= 0 && prev_qty[k] == qty[i] ? 0 : static_cast<uint64_t>(qty[i] / div) + 1);
+    }
+}
+
+/// @brief Inverse of putQuantities(); a 0 with no matching previous level fails the cursor
+void getQuantities(Cursor& in, const Ticks* price, Lots* qty, int size,
+                   const Ticks* prev_price, const Lots* prev_qty, int prev_size, bool ask, int64_t mul) {
+    int j = 0;
+    for (int i = 0; i < size; i++) {
+        uint64_t v = in.varint();
+        if (v != 0) {
+            qty[i] = static_cast<int64_t>(v - 1) * mul;
+            continue;
+        }
+        int k = findLevel(price[i], prev_price, prev_size, ask, j);
+        if (k < 0) {
+            in.ok = false;
+            return;
+        }
+        qty[i] = prev_qty[k];
+    }
+}
+
+}  // namespace
+
+RecordedBook toRecordedBook(int exchange, int pair, const L2OrderBook& ob) {
+    RecordedBook book;
+    book.t_ns = sinceEpochNs(ob.t);
+    book.rx_ns = sinceEpochNs(ob.rxTime);
+    book.exchange = static_cast<uint8_t>(exchange);
+    book.pair = static_cast<uint8_t>(pair);
+    book.price_decimals = static_cast<uint8_t>(ob.scale.price_decimals);
+    book.qty_decimals = static_cast<uint8_t>(ob.scale.qty_decimals);
+    book.askSize = static_cast<uint16_t>(std::clamp(ob.askSize, 0, kMaxSize));
+    book.bidSize = static_cast<uint16_t>(std::clamp(ob.bidSize, 0, kMaxSize));
+    std::copy_n(ob.askPrice, book.askSize, book.askPrice);
+    std::copy_n(ob.askQuantity, book.askSize, book.askQuantity);
+    std::copy_n(ob.bidPrice, book.bidSize, book.bidPrice);
+    std::copy_n(ob.bidQuantity, book.bidSize, book.bidQuantity);
+    return book;
+}
+
+void toL2OrderBook(const RecordedBook& book, L2OrderBook& ob) {
+    ob.t = fromEpochNs(book.t_ns);
+    ob.rxTime = fromEpochNs(book.rx_ns);
+    ob.scale = {book.price_decimals, book.qty_decimals};
+    ob.askSize = book.askSize;
+    ob.bidSize = book.bidSize;
+    std::copy_n(book.askPrice, book.askSize, ob.askPrice);
+    std::copy_n(book.askQuantity, book.askSize, ob.askQuantity);
+    std::copy_n(book.bidPrice, book.bidSize, ob.bidPrice);
+    std::copy_n(book.bidQuantity, book.bidSize, ob.bidQuantity);
+}
+
+void RecordingWriter::open(const std::string& path) {
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_)
+        throw std::runtime_error("cannot create recording " + path);
+
+    RecordingHeader header{};
+    std::memcpy(header.magic, kRecordingMagic, sizeof(kRecordingMagic));
+    header.version = kRecordingVersion;
+    header.header_size = sizeof(RecordingHeader);
+    header.exchange_count = kTotalExchanges;
+    header.pair_count = kTotalPairs;
+    header.created_ns = sinceEpochNs(std::chrono::high_resolution_clock::now());
+    for (int i = 0; i < kTotalExchanges; i++)
+        copyName(header.exchanges[i], kExchanges[i]);
+    for (int i = 0; i < kTotalPairs; i++)
+        copyName(header.pairs[i], kPairs[i]);
+
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out_.flush();
+    if (!out_)
+        throw std::runtime_error("cannot write recording " + path);
+    bytes_written_ = sizeof(header);
+    books_.reserve(kRecordingChunkBooks);
+}
+
+void RecordingWriter::append(const RecordedBook& book) {
+    books_.push_back(book);
+    if (books_.size() == kRecordingChunkBooks)
+        flush();
+}
+
+/**
+ * Implementation notes:
+ * - Books of a feed arrive every few milliseconds and their tops move by a
+ *   few ticks, so the top delta and the level gaps mostly fit one byte;
+ *   quantities carry the entropy and take two or three, except on levels
+ *   the previous book of the stream already had, which take one
+ * - The common powers of ten are found over the whole chunk before
+ *   encoding, so one pass over the buffered books decides them and a
+ *   second one encodes
+ * - The chunk is flushed to the kernel as one write; a crash loses only
+ *   what is still buffered here
+ */
+void RecordingWriter::flush() {
+    if (books_.empty())
+        return;
+
+    int price_exp = 18, qty_exp = 18;
+    for (const RecordedBook& book : books_) {
+        narrowExp(price_exp, book.askPrice, book.askSize);
+        narrowExp(price_exp, book.bidPrice, book.bidSize);
+        narrowExp(qty_exp, book.askQuantity, book.askSize);
+        narrowExp(qty_exp, book.bidQuantity, book.bidSize);
+    }
+    const int64_t price_div = kPow10[price_exp], qty_div = kPow10[qty_exp];
+
+    for (auto& column : columns_)
+        column.clear();
+    std::vector<uint8_t>& meta = columns_[kColumnMeta];
+    std::vector<uint8_t>& time = columns_[kColumnTime];
+    std::vector<uint8_t>& price = columns_[kColumnPrice];
+    std::vector<uint8_t>& qty = columns_[kColumnQuantity];
+
+    TopState top = {};
+    PrevState prev = {};
+    int64_t prev_t = books_.front().t_ns;
+    for (const RecordedBook& book : books_) {
+        meta.push_back(book.exchange);
+        meta.push_back(book.pair);
+        meta.push_back(book.price_decimals);
+        meta.push_back(book.qty_decimals);
+        meta.push_back(static_cast<uint8_t>(book.askSize));
+        meta.push_back(static_cast<uint8_t>(book.bidSize));
+
+        putVarint(time, zigzag(book.t_ns - prev_t));
+        putVarint(time, zigzag(book.t_ns - book.rx_ns));
+        prev_t = book.t_ns;
+
+        int64_t (&last)[2] = top[book.exchange][book.pair];
+        if (book.askSize > 0) {
+            putVarint(price, zigzag((book.askPrice[0] - last[0]) / price_div));
+            last[0] = book.askPrice[0];
+        }
+        for (int i = 1; i < book.askSize; i++)
+            putVarint(price, zigzag((book.askPrice[i] - book.askPrice[i - 1]) / price_div));
+        if (book.bidSize > 0) {
+            putVarint(price, zigzag((book.bidPrice[0] - last[1]) / price_div));
+            last[1] = book.bidPrice[0];
+        }
+        for (int i = 1; i < book.bidSize; i++)
+            putVarint(price, zigzag((book.bidPrice[i - 1] - book.bidPrice[i]) / price_div));
+
+        const RecordedBook* p = prev[book.exchange][book.pair];
+        putQuantities(qty, book.askPrice, book.askQuantity, book.askSize,
+                      p ? p->askPrice : nullptr, p ? p->askQuantity : nullptr, p ? p->askSize : 0, true, qty_div);
+        putQuantities(qty, book.bidPrice, book.bidQuantity, book.bidSize,
+                      p ? p->bidPrice : nullptr, p ? p->bidQuantity : nullptr, p ? p->bidSize : 0, false, qty_div);
+        prev[book.exchange][book.pair] = &book;
+    }
+
+    RecordingChunkHeader header{};
+    header.magic = kRecordingChunkMagic;
+    header.count = static_cast<uint32_t>(books_.size());
+    header.first_t_ns = books_.front().t_ns;
+    header.last_t_ns = books_.back().t_ns;
+    header.price_exp = static_cast<uint8_t>(price_exp);
+    header.qty_exp = static_cast<uint8_t>(qty_exp);
+    uint64_t chunk_bytes = sizeof(header);
+    for (int c = 0; c < kRecordingColumns; c++) {
+        header.column_bytes[c] = static_cast<uint32_t>(columns_[c].size());
+        chunk_bytes += columns_[c].size();
+    }
+
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& column : columns_)
+        out_.write(reinterpret_cast<const char*>(column.data()), static_cast<std::streamsize>(column.size()));
+    out_.flush();
+    if (!out_)
+        throw std::runtime_error("write to recording failed");
+
+    books_written_ += books_.size();
+    bytes_written_ += chunk_bytes;
+    books_.clear();
+}
+
+bool RecordingReader::open(const std::string& path) {
+    in_.open(path, std::ios::binary);
+    if (!in_.read(reinterpret_cast<char*>(&header_), sizeof(header_)))
+        return false;
+    if (std::memcmp(header_.magic, kRecordingMagic, sizeof(kRecordingMagic)) != 0 ||
+        header_.version != kRecordingVersion || header_.header_size != sizeof(RecordingHeader) ||
+        header_.exchange_count > kRecordingMaxNames || header_.pair_count > kRecordingMaxNames)
+        return false;
+    books_.reserve(kRecordingChunkBooks);
+    return true;
+}
+
+bool RecordingReader::next(RecordedBook& book) {
+    if (next_ == books_.size() && !readChunk())
+        return false;
+    book = books_[next_++];
+    return true;
+}
+
+std::string_view RecordingReader::exchangeName(int i) const {
+    if (i < 0 || i >= static_cast<int>(header_.exchange_count))
+        return "?";
+    return {header_.exchanges[i], strnlen(header_.exchanges[i], kRecordingNameSize)};
+}
+
+std::string_view RecordingReader::pairName(int i) const {
+    if (i < 0 || i >= static_cast<int>(header_.pair_count))
+        return "?";
+    return {header_.pairs[i], strnlen(header_.pairs[i], kRecordingNameSize)};
+}
+
+/**
+ * Implementation notes:
+ * - Mirrors RecordingWriter::flush(); every read is bounds-checked, so a
+ *   damaged chunk is rejected instead of producing out-of-range levels
+ * - The previous tops and books start empty in every chunk, as they do
+ *   when encoding, which is what makes chunks decodable on their own
+ */
+bool RecordingReader::readChunk() {
+    books_.clear();
+    next_ = 0;
+
+    RecordingChunkHeader header;
+    if (!in_.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return false;
+    if (header.magic != kRecordingChunkMagic || header.count == 0 || header.count > kRecordingChunkBooks ||
+        header.price_exp > 18 || header.qty_exp > 18)
+        return false;
+    uint64_t payload_bytes = 0;
+    for (uint32_t bytes : header.column_bytes)
+        payload_bytes += bytes;
+    payload_.resize(payload_bytes);
+    if (!in_.read(reinterpret_cast<char*>(payload_.data()), static_cast<std::streamsize>(payload_bytes)))
+        return false;
+
+    Cursor columns[kRecordingColumns];
+    const uint8_t* p = payload_.data();
+    for (int c = 0; c < kRecordingColumns; c++) {
+        columns[c] = {p, p + header.column_bytes[c]};
+        p += header.column_bytes[c];
+    }
+    Cursor& meta = columns[kColumnMeta];
+    Cursor& time = columns[kColumnTime];
+    Cursor& price = columns[kColumnPrice];
+    Cursor& qty = columns[kColumnQuantity];
+    const int64_t price_mul = kPow10[header.price_exp], qty_mul = kPow10[header.qty_exp];
+
+    TopState top = {};
+    PrevState prev = {};
+    int64_t prev_t = header.first_t_ns;
+    books_.resize(header.count);
+    for (RecordedBook& book : books_) {
+        book.exchange = meta.byte();
+        book.pair = meta.byte();
+        book.price_decimals = meta.byte();
+        book.qty_decimals = meta.byte();
+        book.askSize = meta.byte();
+        book.bidSize = meta.byte();
+        if (!meta.ok || book.exchange >= header_.exchange_count || book.pair >= header_.pair_count ||
+            book.price_decimals + book.qty_decimals >= static_cast<int>(kPow10.size()) ||
+            book.askSize > kMaxSize || book.bidSize > kMaxSize)
+            return false;
+
+        book.t_ns = prev_t + time.svarint();
+        book.rx_ns = book.t_ns - time.svarint();
+        prev_t = book.t_ns;
+
+        int64_t (&last)[2] = top[book.exchange][book.pair];
+        if (book.askSize > 0)
+            last[0] = book.askPrice[0] = last[0] + price.svarint() * price_mul;
+        for (int i = 1; i < book.askSize; i++)
+            book.askPrice[i] = book.askPrice[i - 1] + price.svarint() * price_mul;
+        if (book.bidSize > 0)
+            last[1] = book.bidPrice[0] = last[1] + price.svarint() * price_mul;
+        for (int i = 1; i < book.bidSize; i++)
+            book.bidPrice[i] = book.bidPrice[i - 1] - price.svarint() * price_mul;
+
+        const RecordedBook* p = prev[book.exchange][book.pair];
+        getQuantities(qty, book.askPrice, book.askQuantity, book.askSize,
+                      p ? p->askPrice : nullptr, p ? p->askQuantity : nullptr, p ? p->askSize : 0, true, qty_mul);
+        getQuantities(qty, book.bidPrice, book.bidQuantity, book.bidSize,
+                      p ? p->bidPrice : nullptr, p ? p->bidQuantity : nullptr, p ? p->bidSize : 0, false, qty_mul);
+        prev[book.exchange][book.pair] = &book;
+    }
+    return time.ok && price.ok && qty.ok;
+}
+
+BookRecorder::BookRecorder(const std::string& dir)
+    : path_(dir + "/books_" +
+            std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count()) + ".l2rec")
+{
+    writer_.open(path_);
+}
+
+/**
+ * Implementation notes:
+ * - Sleeps on the queue while nothing is buffered; once a chunk is open it
+ *   polls every millisecond so the chunk is written within
+ *   kRecordingFlushInterval of its first book even if the feed goes quiet
+ * - A write error stops the recorder; later books fill the queue and are
+ *   counted as dropped
+ * - stop() is an entry in the same queue, so every book queued ahead of it
+ *   is written before the last chunk is flushed
+ */
+void BookRecorder::run() {
+    RecordedBook book;
+    auto flush_by = std::chrono::steady_clock::time_point::max();
+    try {
+        while (true) {
+            if (!ring_.tryPop(book)) {
+                if (writer_.pending() == 0) {
+                    ring_.pop(book);
+                } else if (std::chrono::steady_clock::now() >= flush_by) {
+                    writer_.flush();
+                    flush_by = std::chrono::steady_clock::time_point::max();
+                    recorded_.store(writer_.booksWritten(), std::memory_order_relaxed);
+                    bytes_.store(writer_.bytesWritten(), std::memory_order_relaxed);
+                    continue;
+                } else {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+            }
+            if (book.exchange == kStopExchange) {
+                writer_.flush();
+                recorded_.store(writer_.booksWritten(), std::memory_order_relaxed);
+                bytes_.store(writer_.bytesWritten(), std::memory_order_relaxed);
+                break;
+            }
+            if (writer_.pending() == 0)
+                flush_by = std::chrono::steady_clock::now() + kRecordingFlushInterval;
+            writer_.append(book);
+            if (writer_.pending() == 0) {
+                flush_by = std::chrono::steady_clock::time_point::max();
+                recorded_.store(writer_.booksWritten(), std::memory_order_relaxed);
+                bytes_.store(writer_.bytesWritten(), std::memory_order_relaxed);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "recorder: " << e.what() << ", recording stopped\n";
+    }
+    finished_.store(true, std::memory_order_release);
+}
+
+/**
+ * Implementation notes:
+ * - Retries while the queue is full, unless run() already gave up on a
+ *   write error and nothing will drain it
+ */
+void BookRecorder::stop() {
+    RecordedBook end{};
+    end.exchange = kStopExchange;
+    while (!ring_.tryPush(end) && !finished_.load(std::memory_order_acquire))
+        std::this_thread::yield();
+}
@@ -0,0 +1,266 @@
+#include "replay.hpp"
+#include "clock.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+/// @brief Reads a fixed-width decimal field of a timestamp
+bool digits(std::string_view s, size_t pos, size_t len, int& out) {
+    const char* end = s.data() + pos + len;
+    return std::from_chars(s.data() + pos, end, out).ptr == end;
+}
+
+/**
+ * @brief Parses an ISO-8601 UTC time such as "2025-05-04T10:39:13.040Z"
+ * @param s Text of the time; fractional seconds are optional, up to nanoseconds are kept
+ * @param ns Set to nanoseconds since the epoch
+ * @return false if s is not in that form
+ */
+bool parseIsoTime(std::string_view s, int64_t& ns) {
+    int y, mo, d, h, mi, sec;
+    if (s.size() < 20 || s[4] != '-' || s[7] != '-' || s[10] != 'T' || s[13] != ':' || s[16] != ':' ||
+        !digits(s, 0, 4, y) || !digits(s, 5, 2, mo) || !digits(s, 8, 2, d) ||
+        !digits(s, 11, 2, h) || !digits(s, 14, 2, mi) || !digits(s, 17, 2, sec))
+        return false;
+    std::chrono::year_month_day date{std::chrono::year{y}, std::chrono::month(mo), std::chrono::day(d)};
+    if (!date.ok() || h > 23 || mi > 59 || sec > 60)
+        return false;
+
+    int64_t frac = 0;
+    int frac_digits = 0;
+    size_t i = 19;
+    if (s[i] == '.') {
+        for (i++; i < s.size() && s[i] >= '0' && s[i] <= '9'; i++) {
+            if (frac_digits < 9) {
+                frac = frac * 10 + (s[i] - '0');
+                frac_digits++;
+            }
+        }
+    }
+    if (i != s.size() - 1 || s[i] != 'Z')
+        return false;
+    for (; frac_digits < 9; frac_digits++)
+        frac *= 10;
+
+    int64_t days = std::chrono::sys_days(date).time_since_epoch().count();
+    ns = (((days * 24 + h) * 60 + mi) * 60 + sec) * 1000000000LL + frac;
+    return true;
+}
+
+/**
+ * @brief Reads the "timestamp" field of a payload
+ *
+ * Accepts ISO-8601 UTC text, as the gomarket feeds send, or a number of
+ * milliseconds since the epoch.
+ */
+bool messageTime(simdjson::ondemand::document& doc, int64_t& ns) {
+    simdjson::ondemand::value ts;
+    simdjson::ondemand::json_type type;
+    if (doc["timestamp"].get(ts) != simdjson::SUCCESS || ts.type().get(type) != simdjson::SUCCESS)
+        return false;
+    if (type == simdjson::ondemand::json_type::string) {
+        std::string_view text;
+        return ts.get_string().get(text) == simdjson::SUCCESS && parseIsoTime(text, ns);
+    }
+    int64_t ms;
+    if (type != simdjson::ondemand::json_type::number || ts.get_int64().get(ms) != simdjson::SUCCESS)
+        return false;
+    ns = ms * 1000000;
+    return true;
+}
+
+/// @brief Time point of nanoseconds since the epoch
+std::chrono::high_resolution_clock::time_point fromEpochNs(int64_t ns) {
+    return std::chrono::high_resolution_clock::time_point(
+        std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::nanoseconds(ns)));
+}
+
+/// @brief Waits until a detector has finished count updates
+void awaitDetector(const Metrics& metrics, uint64_t count) {
+    while (metrics.updates_processed.load(std::memory_order_acquire) +
+           metrics.updates_superseded.load(std::memory_order_acquire) < count)
+        std::this_thread::yield();
+}
+
+}  // namespace
+
+/**
+ * Implementation notes:
+ * - Capture files are matched by the name wsClient gives them; files of
+ *   disabled exchanges or pairs are not opened at all
+ * - Captures are sorted by (exchange, pair), which breaks timestamp ties
+ *   the same way on every run
+ */
+void ReplayFeed::open(const std::string& path, const config& cfg) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    if (!fs::exists(path, ec))
+        throw std::runtime_error("cannot replay " + path + ": no such file or directory");
+    if (!fs::is_directory(path, ec)) {
+        if (!recording_.open(path))
+            throw std::runtime_error("cannot replay " + path + ": not a book recording of this version");
+        from_recording_ = true;
+        for (int i = 0; i < kRecordingMaxNames; i++) {
+            exchange_index_[i] = getIndex(recording_.exchangeName(i), 1);
+            pair_index_[i] = getIndex(recording_.pairName(i), 2);
+        }
+        return;
+    }
+
+    for (const auto& entry : fs::directory_iterator(path, ec)) {
+        std::string name = entry.path().filename().string();
+        size_t underscore = name.find('_');
+        if (entry.path().extension() != ".jsonl" || underscore == std::string::npos)
+            continue;
+        std::string pair_name = name.substr(underscore + 1, name.size() - underscore - 1 - 6);
+        std::replace(pair_name.begin(), pair_name.end(), '-', '/');
+        int exchange = getIndex(name.substr(0, underscore), 1);
+        int pair = getIndex(pair_name, 2);
+        if (exchange == -1 || pair == -1) {
+            std::cerr << "replay: ignoring " << entry.path() << ", not a capture file\n";
+            continue;
+        }
+        if (!cfg.exchanges[exchange] || !cfg.pairs[pair])
+            continue;
+
+        auto capture = std::make_unique<Capture>();
+        capture->exchange = exchange;
+        capture->pair = pair;
+        capture->parse = bookParserFor(exchange);
+        capture->in.open(entry.path());
+        capture->book = {};
+        capture->book.scale = cfg.scales[pair];
+        if (!capture->in)
+            throw std::runtime_error("cannot open capture " + entry.path().string());
+        captures_.push_back(std::move(capture));
+    }
+    if (ec)
+        throw std::runtime_error("cannot list " + path + ": " + ec.message());
+    if (captures_.empty())
+        throw std::runtime_error("cannot replay " + path + ": no capture file of an enabled exchange and pair");
+
+    std::sort(captures_.begin(), captures_.end(), [](const auto& a, const auto& b) {
+        return std::pair(a->exchange, a->pair) < std::pair(b->exchange, b->pair);
+    });
+    for (auto& capture : captures_)
+        readCapture(*capture);
+}
+
+bool ReplayFeed::next(int& exchange, int& pair, L2OrderBook& ob) {
+    if (from_recording_) {
+        while (recording_.next(recorded_)) {
+            exchange = exchange_index_[recorded_.exchange];
+            pair = pair_index_[recorded_.pair];
+            if (exchange == -1 || pair == -1) {
+                skipped_++;
+                continue;
+            }
+            toL2OrderBook(recorded_, ob);
+            return true;
+        }
+        return false;
+    }
+
+    Capture* earliest = nullptr;
+    for (auto& capture : captures_)
+        if (capture->ready && (!earliest || capture->book.t < earliest->book.t))
+            earliest = capture.get();
+    if (!earliest)
+        return false;
+    exchange = earliest->exchange;
+    pair = earliest->pair;
+    ob = earliest->book;
+    readCapture(*earliest);
+    return true;
+}
+
+/**
+ * Implementation notes:
+ * - Uses the parser wsClient uses for the exchange, so payloads become
+ *   the same fixed-point books they did live
+ * - A payload without a usable timestamp, or that fails to parse, is
+ *   skipped and counted
+ */
+bool ReplayFeed::readCapture(Capture& capture) {
+    capture.ready = false;
+    while (std::getline(capture.in, line_)) {
+        if (line_.empty())
+            continue;
+        try {
+            simdjson::padded_string payload(line_);
+            simdjson::ondemand::document doc = parser_.iterate(payload);
+            int64_t ns;
+            if (!messageTime(doc, ns)) {
+                skipped_++;
+                continue;
+            }
+            capture.parse(doc, capture.book);
+            capture.book.t = capture.book.rxTime = fromEpochNs(ns);
+        } catch (const simdjson::simdjson_error&) {
+            skipped_++;
+            continue;
+        }
+        capture.ready = true;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Implementation notes:
+ * - Paced replays sleep until each book is due, measured from the first
+ *   book; a replay that falls behind injects without sleeping
+ * - The workers count an update as processed only after publishing its
+ *   results, so waiting on that count is a full handshake
+ */
+void replayBooks(ReplayFeed& feed, const config& cfg, std::vector<PairBooks>& markets,
+                 CycleEngine& cycles, ReplayStats& stats)
+{
+    L2OrderBook ob{};
+    int exchange, pair;
+    uint64_t injected[kTotalPairs] = {};
+    uint64_t cycle_injected = 0;
+    bool overflow_warned = false;
+    const double speed = cfg.replay.speed;
+    std::chrono::high_resolution_clock::time_point first_t;
+    std::chrono::steady_clock::time_point started;
+    bool paced = false;
+
+    while (!stats.stop.load(std::memory_order_relaxed) && feed.next(exchange, pair, ob)) {
+        if (!cfg.exchanges[exchange] || !cfg.pairs[pair]) {
+            stats.skipped++;
+            continue;
+        }
+        if (speed > 0.0) {
+            if (!paced) {
+                first_t = ob.t;
+                started = std::chrono::steady_clock::now();
+                paced = true;
+            }
+            std::this_thread::sleep_until(
+                started + std::chrono::duration_cast<std::chrono::steady_clock::duration>((ob.t - first_t) / speed));
+        }
+
+        DetectionClock::anchor(ob.t);
+        PairBooks& market = markets[pair];
+        Lots max_lots = toFixed(cfg.max_order_size, ob.scale.qty_decimals);
+        if (!ingestBook(exchange, pair, ob, max_lots, market.books[exchange], market.events, market.cycle_events) &&
+            !overflow_warned) {
+            std::cerr << "replay: " << kExchanges[exchange] << " " << kPairs[pair]
+                      << ": notional overflows int64, lower the pair's scales\n";
+            overflow_warned = true;
+        }
+        awaitDetector(market.metrics, ++injected[pair]);
+        if (market.cycle_events)
+            awaitDetector(cycles.metrics, ++cycle_injected);
+        stats.replayed++;
+    }
+    stats.skipped += feed.skipped();
+    stats.done = true;
+}
@@ -0,0 +1,110 @@
+#include "rx_socket.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <type_traits>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <sys/socket.h>
+
+namespace {
+
+/**
+ * @brief Converts a kernel CLOCK_REALTIME timespec to a high_resolution_clock time point
+ *
+ * libstdc++ makes high_resolution_clock the system clock, so the
+ * timestamp converts directly. Where it is another clock (steady_clock on
+ * libc++), the timestamp's age is measured on the system clock and taken
+ * off high_resolution_clock::now().
+ */
+std::chrono::high_resolution_clock::time_point fromTimespec(const timespec& ts) {
+    using HighRes = std::chrono::high_resolution_clock;
+    auto since_epoch = std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+    std::chrono::system_clock::time_point wall(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(since_epoch));
+    if constexpr (std::is_same_v<HighRes, std::chrono::system_clock>) {
+        return wall;
+    } else {
+        auto age = std::chrono::system_clock::now() - wall;
+        return HighRes::now() - std::chrono::duration_cast<HighRes::duration>(age);
+    }
+}
+
+}  // namespace
+
+/**
+ * Implementation notes:
+ * - SO_TIMESTAMPING reports software and raw hardware stamps in one
+ *   control message; SO_TIMESTAMPNS is the fallback for older kernels
+ * - NIC hardware stamping must also be enabled on the interface
+ *   (SIOCSHWTSTAMP, e.g. with hwstamp_ctl); without it ts[2] stays zero
+ *   and the software stamp is used
+ */
+void RxTimestampSocket::enableTimestamps() {
+    enabled_ = true;
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (hardware_)
+        flags |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+    if (setsockopt(native_handle(), SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0)
+        return;
+    int on = 1;
+    setsockopt(native_handle(), SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+}
+
+/**
+ * Implementation notes:
+ * - MSG_DONTWAIT keeps the call non-blocking whatever the socket mode
+ * - A read without a timestamp control message falls back to the current
+ *   time, which still excludes TLS decryption and framing
+ */
+size_t RxTimestampSocket::receive(iovec* iov, int count, boost::system::error_code& ec,
+                                  bool& would_block) {
+    if (!enabled_)
+        enableTimestamps();
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(scm_timestamping)) + CMSG_SPACE(sizeof(timespec))];
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = recvmsg(native_handle(), &msg, MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            would_block = true;
+        else
+            ec = boost::system::error_code(errno, boost::system::system_category());
+        return 0;
+    }
+    if (n == 0) {
+        ec = boost::asio::error::eof;
+        return 0;
+    }
+
+    rx_time_ = std::chrono::high_resolution_clock::now();
+    for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+        if (cm->cmsg_level != SOL_SOCKET)
+            continue;
+        if (cm->cmsg_type == SCM_TIMESTAMPING) {
+            scm_timestamping ts;
+            std::memcpy(&ts, CMSG_DATA(cm), sizeof(ts));
+            const timespec& hw = ts.ts[2];
+            const timespec& sw = ts.ts[0];
+            if (hardware_ && (hw.tv_sec != 0 || hw.tv_nsec != 0))
+                rx_time_ = fromTimespec(hw);
+            else if (sw.tv_sec != 0 || sw.tv_nsec != 0)
+                rx_time_ = fromTimespec(sw);
+        } else if (cm->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec ts;
+            std::memcpy(&ts, CMSG_DATA(cm), sizeof(ts));
+            rx_time_ = fromTimespec(ts);
+        }
+    }
+    return static_cast<size_t>(n);
+}
@@ -0,0 +1,291 @@
+#include "triangular.hpp"
+#include "clock.hpp"
+#include <algorithm>
+#include <chrono>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+/// @brief Share of a leg's output kept after a fee in parts per kFeeDen
+double feeMultiplier(int64_t fee) {
+    return static_cast<double>(kFeeDen - fee) / kFeeDen;
+}
+
+/// @brief Rate of a leg inside one level: output per unit of input, after the fee
+double levelRate(const CycleLeg& leg, const L2OrderBook& ob, int level, double fee_mult) {
+    return leg.buy_base ? fee_mult / toPrice(ob, ob.askPrice[level])
+                        : fee_mult * toPrice(ob, ob.bidPrice[level]);
+}
+
+/// @brief Input a leg has consumed at the end of one level
+double levelEnd(const CycleLeg& leg, const L2OrderBook& ob, int level) {
+    return leg.buy_base ? toNotional(ob, ob.askCumCost[level])
+                        : toQuantity(ob, ob.bidCumQty[level]);
+}
+
+/// @brief Number of levels of the side a leg trades on
+int legDepth(const CycleLeg& leg, const L2OrderBook& ob) {
+    return leg.buy_base ? ob.askDepth : ob.bidDepth;
+}
+
+/// @brief Index of a (exchange, pair) book in the detector's flat arrays
+int bookSlot(int exchange, int pair) {
+    return pair * kTotalExchanges + exchange;
+}
+
+}  // namespace
+
+/**
+ * Implementation notes:
+ * - Currencies and edges come from the enabled pairs only, so a triangle
+ *   needs all three of its pairs subscribed
+ * - Exchange assignments are enumerated per leg, which covers single-venue
+ *   cycles and every cross-venue combination
+ */
+std::vector<Cycle> buildCycles(const config& cfg) {
+    std::vector<std::string_view> currencies;
+    for (int p = 0; p < kTotalPairs; p++) {
+        if (!cfg.pairs[p])
+            continue;
+        for (std::string_view c : {pairBase(p), pairQuote(p)})
+            if (std::find(currencies.begin(), currencies.end(), c) == currencies.end())
+                currencies.push_back(c);
+    }
+
+    auto pairBetween = [&](std::string_view a, std::string_view b) {
+        for (int p = 0; p < kTotalPairs; p++) {
+            if (!cfg.pairs[p])
+                continue;
+            if ((pairBase(p) == a && pairQuote(p) == b) || (pairBase(p) == b && pairQuote(p) == a))
+                return p;
+        }
+        return -1;
+    };
+    auto quotedPairs = [&](std::string_view c) {
+        int n = 0;
+        for (int p = 0; p < kTotalPairs; p++)
+            n += cfg.pairs[p] && pairQuote(p) == c;
+        return n;
+    };
+
+    std::vector<int> exchanges;
+    for (int e = 0; e < kTotalExchanges; e++)
+        if (cfg.exchanges[e])
+            exchanges.push_back(e);
+
+    std::vector<Cycle> cycles;
+    const int n = static_cast<int>(currencies.size());
+    for (int a = 0; a < n; a++) {
+        for (int b = a + 1; b < n; b++) {
+            for (int c = b + 1; c < n; c++) {
+                std::string_view tri[3] = {currencies[a], currencies[b], currencies[c]};
+                if (pairBetween(tri[0], tri[1]) == -1 || pairBetween(tri[1], tri[2]) == -1 ||
+                    pairBetween(tri[2], tri[0]) == -1)
+                    continue;
+
+                // Rotate the most common quote currency to the front
+                int start = 0;
+                for (int i = 1; i < 3; i++)
+                    if (quotedPairs(tri[i]) > quotedPairs(tri[start]))
+                        start = i;
+                std::rotate(tri, tri + start, tri + 3);
+
+                for (bool reversed : {false, true}) {
+                    std::string_view path[4] = {tri[0], reversed ? tri[2] : tri[1],
+                                                reversed ? tri[1] : tri[2], tri[0]};
+                    Cycle cycle;
+                    for (int k = 0; k < kCycleLegs; k++) {
+                        int pair = pairBetween(path[k], path[k + 1]);
+                        cycle.legs[k] = {0, pair, pairBase(pair) == path[k + 1]};
+                    }
+                    for (int e0 : exchanges) {
+                        for (int e1 : exchanges) {
+                            for (int e2 : exchanges) {
+                                cycle.legs[0].exchange = e0;
+                                cycle.legs[1].exchange = e1;
+                                cycle.legs[2].exchange = e2;
+                                cycles.push_back(cycle);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return cycles;
+}
+
+/**
+ * Implementation notes:
+ * - in[k] is the amount leg k has consumed; in[k + 1] is leg k's output
+ * - Each step advances the start amount until one leg reaches the end of
+ *   its current level; that leg's input is snapped to the level boundary
+ *   so rounding cannot accumulate, and it moves to its next level
+ * - Every step completes a level of some leg, so the walk takes at most
+ *   the sum of the three depths
+ * - Stops when the cycle's marginal rate drops to 1 or a leg runs out of
+ *   capped depth
+ * - Fees and level boundaries are the fixed-point ones of the two-leg
+ *   path (feeUnits(), the integer cumulative arrays); only the walk is in
+ *   double, since a leg's rate converts between the scales of two different
+ *   pairs and the composed rate of three legs has no common integer unit
+ */
+bool evaluateCycle(const Cycle& cycle, const L2OrderBook* const books[kCycleLegs],
+                   const int64_t* fees, double min_profit, CycleOpportunity& best)
+{
+    int depth[kCycleLegs];
+    double fee_mult[kCycleLegs];
+    for (int k = 0; k < kCycleLegs; k++) {
+        depth[k] = legDepth(cycle.legs[k], *books[k]);
+        if (depth[k] == 0)
+            return false;
+        fee_mult[k] = feeMultiplier(fees[cycle.legs[k].exchange]);
+    }
+
+    double in[kCycleLegs] = {0.0, 0.0, 0.0};
+    double out = 0.0;
+    int level[kCycleLegs] = {0, 0, 0};
+
+    while (level[0] < depth[0] && level[1] < depth[1] && level[2] < depth[2]) {
+        double r0 = levelRate(cycle.legs[0], *books[0], level[0], fee_mult[0]);
+        double r1 = levelRate(cycle.legs[1], *books[1], level[1], fee_mult[1]);
+        double r2 = levelRate(cycle.legs[2], *books[2], level[2], fee_mult[2]);
+        // Derivatives of each leg's input, and of the final output, by the start amount
+        double grad[kCycleLegs + 1] = {1.0, r0, r0 * r1, r0 * r1 * r2};
+        if (grad[3] <= 1.0)
+            break;
+
+        double step = 0.0;
+        int leg = -1;
+        for (int k = 0; k < kCycleLegs; k++) {
+            double room = std::max(0.0, levelEnd(cycle.legs[k], *books[k], level[k]) - in[k]) / grad[k];
+            if (leg == -1 || room < step) {
+                step = room;
+                leg = k;
+            }
+        }
+
+        for (int k = 0; k < kCycleLegs; k++)
+            in[k] += grad[k] * step;
+        out += grad[3] * step;
+        in[leg] = levelEnd(cycle.legs[leg], *books[leg], level[leg]);
+        level[leg]++;
+    }
+
+    double net_profit = out - in[0];
+    if (in[0] <= 0.0 || net_profit < min_profit)
+        return false;
+
+    for (int k = 0; k < kCycleLegs; k++) {
+        const CycleLeg& leg = cycle.legs[k];
+        double consumed = level[k] > 0 ? levelEnd(leg, *books[k], level[k] - 1) : 0.0;
+        best.exchanges[k] = leg.exchange;
+        best.pairs[k] = leg.pair;
+        best.buy_base[k] = leg.buy_base;
+        best.levels[k] = std::min(depth[k], level[k] + (in[k] > consumed ? 1 : 0));
+    }
+    best.start_amount = in[0];
+    best.end_amount = out;
+    best.net_profit = net_profit;
+    best.profit_pct = net_profit / in[0] * 100.0;
+    return true;
+}
+
+/**
+ * Implementation notes:
+ * - Keeps its own torn-free copies of the leg books; a book that has not
+ *   been received yet has depth 0 and fails its cycles immediately
+ * - Cycles through each book are indexed once at startup, so an update
+ *   only touches the cycles it can change; the output buffer is sized for
+ *   the busiest book, so no update allocates
+ * - Skips cycles with a leg book older than its venue's max_book_age_ms,
+ *   aged once per event from the books' socket receive times
+ * - Rejects a cycle from top of book alone when the product of the best
+ *   rates after fees does not exceed 1; deeper levels only get worse
+ */
+void cycleProcess(std::vector<PairBooks>& markets, CycleEngine& engine,
+                  const std::vector<Cycle>& cycles, config& cfg, OpportunitySink& sink)
+{
+    std::vector<L2OrderBook> local_books(kTotalPairs * kTotalExchanges);
+    std::vector<std::vector<int>> cycles_through(kTotalPairs * kTotalExchanges);
+    for (int c = 0; c < static_cast<int>(cycles.size()); c++)
+        for (const CycleLeg& leg : cycles[c].legs)
+            cycles_through[bookSlot(leg.exchange, leg.pair)].push_back(c);
+
+    Metrics& metrics = engine.metrics;
+    std::vector<CycleOpportunity> found;
+    size_t most_cycles = 0;
+    for (const auto& through : cycles_through)
+        most_cycles = std::max(most_cycles, through.size());
+    found.reserve(most_cycles);
+    int64_t fees[kTotalExchanges];
+    for (int e = 0; e < kTotalExchanges; e++)
+        fees[e] = feeUnits(cfg.fees[e]);
+    BookEvent ev;
+
+    while (true) {
+        engine.events.pop(ev);
+        if (ev.exchange == kStopEvent)
+            return;
+        int slot = bookSlot(ev.exchange, ev.pair);
+        if (markets[ev.pair].books[ev.exchange].read(local_books[slot]) != ev.sequence) {
+            metrics.updates_superseded++;
+            continue;
+        }
+
+        found.clear();
+        uint64_t pruned = 0, skipped = 0;
+        auto aged_at = DetectionClock::now();
+        for (int c : cycles_through[slot]) {
+            const Cycle& cycle = cycles[c];
+            const L2OrderBook* books[kCycleLegs];
+            int64_t age_us[kCycleLegs];
+            double top_rate = 1.0;
+            bool empty = false, stale = false;
+            for (int k = 0; k < kCycleLegs; k++) {
+                const CycleLeg& leg = cycle.legs[k];
+                books[k] = &local_books[bookSlot(leg.exchange, leg.pair)];
+                if (legDepth(leg, *books[k]) == 0) {
+                    empty = true;
+                    break;
+                }
+                age_us[k] = bookAgeUs(*books[k], aged_at);
+                stale |= isStale(age_us[k], cfg.max_book_age_ms[leg.exchange]);
+                top_rate *= levelRate(leg, *books[k], 0, feeMultiplier(fees[leg.exchange]));
+            }
+            if (empty)
+                continue;
+            if (stale) {
+                ++skipped;
+                continue;
+            }
+            if (top_rate <= 1.0) {
+                ++pruned;
+                continue;
+            }
+
+            CycleOpportunity opp;
+            if (!evaluateCycle(cycle, books, fees, cfg.min_profit, opp))
+                continue;
+
+            auto now = DetectionClock::now();
+            auto latency = now < ev.t ? 0 : std::chrono::duration_cast<std::chrono::microseconds>(
+                now - ev.t).count();
+            opp.detection_latency_us = static_cast<double>(latency);
+            opp.detection_time = now;
+            for (int k = 0; k < kCycleLegs; k++)
+                opp.book_age_us[k] = static_cast<double>(age_us[k]);
+            found.push_back(opp);
+
+            metrics.opportunities_found++;
+            metrics.updateLatency(static_cast<uint64_t>(latency));
+        }
+        metrics.pairs_pruned += pruned;
+        metrics.stale_skipped += skipped;
+        if (!found.empty())
+            sink.publishCycles(found);
+        // Counted once fully handled, which replay waits on
+        metrics.updates_processed++;
+    }
+}
@@ -1,4 +1,6 @@
 #include "utils.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <exception>
 #include <stdexcept>
 #include <string_view>
@@ -9,6 +11,7 @@
  * - Validates all required configuration fields
  * - Ensures 1-1 mapping between exchanges and fees
  * - Performs type checking on numeric values
+ * - Falls back to defaults only for optional keys that are absent
  * - Exits with failure on invalid configuration
  */
 void loadConfig(const std::string& file_path, config& config, simdjson::ondemand::parser& parser) {
@@ -30,18 +33,177 @@ void loadConfig(const std::string& file_path, config& config, simdjson::ondemand
     int num_pairs = 0;
     for (auto pair: object["pairs"]) {
         int index = getIndex(pair.get_string(), 2);
-        if (index == -1) throw std::runtime_error("unknown pair.\narb supported pairs: BTC/USDT, ETH/USDT, SOL/USDT");
+        if (index == -1) throw std::runtime_error("unknown pair.\narb supported pairs: BTC/USDT, ETH/USDT, SOL/USDT, ETH/BTC");
         config.pairs[index] = true;
         num_pairs++;
     }
     if (num_pairs == 0)
         throw std::runtime_error("found empty pairs.\nplease fill config.json");
-    if (num_pairs > 1)
-        throw std::runtime_error("sorry, currently only one pair is supported.\n");
 
     config.min_profit = object["min_profit"].get_double();
     config.max_order_size = object["max_order_size"].get_double();
     config.latency_ms = object["latency_ms"].get_double();
+    auto incremental = object["incremental"];
+    config.incremental = incremental.error() == simdjson::NO_SUCH_FIELD ? true : bool(incremental.get_bool());
+    auto triangular = object["triangular"];
+    config.triangular = triangular.error() == simdjson::NO_SUCH_FIELD ? false : bool(triangular.get_bool());
+    config.detect_threads = 0;
+    config.detect_min_pairs = kDefaultDetectMinPairs;
+    simdjson::ondemand::object parallel_detection;
+    if (object["parallel_detection"].get(parallel_detection) == simdjson::SUCCESS) {
+        int64_t helpers, min_pairs;
+        if (parallel_detection["threads"].get(helpers) == simdjson::SUCCESS) {
+            if (helpers < 0 || helpers > kMaxDetectThreads)
+                throw std::runtime_error("parallel_detection threads out of range.\nthreads must be between 0 and 64");
+            config.detect_threads = static_cast<int>(helpers);
+        }
+        if (parallel_detection["min_pairs"].get(min_pairs) == simdjson::SUCCESS) {
+            if (min_pairs < 1)
+                throw std::runtime_error("parallel_detection min_pairs out of range.\nmin_pairs must be at least 1");
+            config.detect_min_pairs = static_cast<int>(std::min<int64_t>(min_pairs, INT32_MAX));
+        }
+    }
+    auto io_threads = object["io_threads"];
+    int64_t threads = io_threads.error() == simdjson::NO_SUCH_FIELD ? 1 : int64_t(io_threads.get_int64());
+    if (threads < 1 || threads > kMaxIoThreads)
+        throw std::runtime_error("io_threads out of range.\nio_threads must be between 1 and the number of connections");
+    config.io_threads = static_cast<int>(threads);
+
+    auto hw_timestamps = object["hw_timestamps"];
+    config.hw_timestamps = hw_timestamps.error() == simdjson::NO_SUCH_FIELD ? false : bool(hw_timestamps.get_bool());
+    std::string_view capture_dir;
+    if (object["capture_dir"].get(capture_dir) == simdjson::SUCCESS)
+        config.capture_dir = capture_dir;
+    std::string_view record_dir;
+    if (object["record_dir"].get(record_dir) == simdjson::SUCCESS)
+        config.record_dir = record_dir;
+
+    config.low_latency = {false, 0, {}, 0, -1, {}, 0, {}, 0};
+    simdjson::ondemand::object low_latency;
+    if (object["low_latency"].get(low_latency) == simdjson::SUCCESS) {
+        LowLatency& ll = config.low_latency;
+        auto busy_poll = low_latency["busy_poll"];
+        ll.busy_poll = busy_poll.error() == simdjson::NO_SUCH_FIELD ? false : bool(busy_poll.get_bool());
+        auto rt_priority = low_latency["rt_priority"];
+        ll.rt_priority = rt_priority.error() == simdjson::NO_SUCH_FIELD ? 0 : static_cast<int>(int64_t(rt_priority.get_int64()));
+        if (ll.rt_priority < 0 || ll.rt_priority > 99)
+            throw std::runtime_error("rt_priority out of range.\nrt_priority must be between 0 (disabled) and 99");
+        simdjson::ondemand::array process_cores;
+        if (low_latency["process_cores"].get(process_cores) == simdjson::SUCCESS) {
+            for (auto core : process_cores) {
+                if (ll.process_core_count == kTotalPairs)
+                    throw std::runtime_error("too many process_cores.\nlist at most one core per pair");
+                ll.process_cores[ll.process_core_count++] = static_cast<int>(int64_t(core.get_int64()));
+            }
+        } else {
+            // Single-pair configs name one core for the only process thread
+            auto process_core = low_latency["process_core"];
+            if (process_core.error() != simdjson::NO_SUCH_FIELD) {
+                int core = static_cast<int>(int64_t(process_core.get_int64()));
+                if (core != -1)
+                    ll.process_cores[ll.process_core_count++] = core;
+            }
+        }
+        auto db_core = low_latency["db_core"];
+        ll.db_core = db_core.error() == simdjson::NO_SUCH_FIELD ? -1 : static_cast<int>(int64_t(db_core.get_int64()));
+        simdjson::ondemand::array io_cores;
+        if (low_latency["io_cores"].get(io_cores) == simdjson::SUCCESS) {
+            for (auto core : io_cores) {
+                if (ll.io_core_count == kMaxIoThreads)
+                    throw std::runtime_error("too many io_cores.\nlist at most one core per I/O thread");
+                ll.io_cores[ll.io_core_count++] = static_cast<int>(int64_t(core.get_int64()));
+            }
+        }
+        simdjson::ondemand::array detect_cores;
+        if (low_latency["detect_cores"].get(detect_cores) == simdjson::SUCCESS) {
+            for (auto core : detect_cores) {
+                if (ll.detect_core_count == kTotalPairs * kMaxDetectThreads)
+                    throw std::runtime_error("too many detect_cores.\nlist at most one core per detection helper");
+                ll.detect_cores[ll.detect_core_count++] = static_cast<int>(int64_t(core.get_int64()));
+            }
+        }
+        if (ll.db_core < -1)
+            throw std::runtime_error("negative core in low_latency.\nuse -1 or omit the key to leave a thread unpinned");
+        for (int i = 0; i < ll.io_core_count; i++)
+            if (ll.io_cores[i] < 0)
+                throw std::runtime_error("negative core in io_cores.");
+        for (int i = 0; i < ll.process_core_count; i++)
+            if (ll.process_cores[i] < 0)
+                throw std::runtime_error("negative core in process_cores.");
+        for (int i = 0; i < ll.detect_core_count; i++)
+            if (ll.detect_cores[i] < 0)
+                throw std::runtime_error("negative core in detect_cores.");
+    }
+
+    config.db = {1, 1000, 100.0};
+    simdjson::ondemand::object db;
+    if (object["db"].get(db) == simdjson::SUCCESS) {
+        std::string_view synchronous;
+        if (db["synchronous"].get(synchronous) == simdjson::SUCCESS) {
+            auto level = std::find(kDbSynchronousLevels.begin(), kDbSynchronousLevels.end(), synchronous);
+            if (level == kDbSynchronousLevels.end())
+                throw std::runtime_error("unknown db synchronous level.\narb supported levels: off, normal, full, extra");
+            config.db.synchronous = static_cast<int>(level - kDbSynchronousLevels.begin());
+        }
+        int64_t batch_rows;
+        if (db["batch_rows"].get(batch_rows) == simdjson::SUCCESS) {
+            if (batch_rows < 1 || batch_rows > INT32_MAX)
+                throw std::runtime_error("db batch_rows out of range.\nbatch_rows must be at least 1");
+            config.db.batch_rows = static_cast<int>(batch_rows);
+        }
+        double batch_ms;
+        if (db["batch_ms"].get(batch_ms) == simdjson::SUCCESS) {
+            if (batch_ms < 0)
+                throw std::runtime_error("negative db batch_ms.\nuse 0 to commit every drained batch");
+            config.db.batch_ms = batch_ms;
+        }
+    }
+
+    config.replay = {{}, 1.0, false};
+    simdjson::ondemand::object replay;
+    if (object["replay"].get(replay) == simdjson::SUCCESS) {
+        std::string_view path;
+        if (replay["path"].get(path) != simdjson::SUCCESS || path.empty())
+            throw std::runtime_error("replay needs a path.\npath is a .l2rec recording or a capture_dir directory");
+        config.replay.path = path;
+        double speed;
+        if (replay["speed"].get(speed) == simdjson::SUCCESS) {
+            if (speed < 0)
+                throw std::runtime_error("negative replay speed.\nuse 0 to replay as fast as possible");
+            config.replay.speed = speed;
+        }
+        bool exit_when_done;
+        if (replay["exit_when_done"].get(exit_when_done) == simdjson::SUCCESS)
+            config.replay.exit_when_done = exit_when_done;
+    }
+
+    for (int i = 0; i < kTotalPairs; i++)
+        config.scales[i] = kDefaultScales[i];
+    simdjson::ondemand::object scales;
+    if (object["scales"].get(scales) == simdjson::SUCCESS) {
+        for (auto scale : scales) {
+            int index = getIndex(scale.escaped_key(), 2);
+            if (index == -1) throw std::runtime_error("unknown pair in scales.\narb supported pairs: BTC/USDT, ETH/USDT, SOL/USDT, ETH/BTC");
+            simdjson::ondemand::object decimals = scale.value().get_object();
+            int64_t price_decimals = decimals["price_decimals"].get_int64();
+            int64_t qty_decimals = decimals["qty_decimals"].get_int64();
+            if (price_decimals < 0 || qty_decimals < 0 || price_decimals + qty_decimals > 16)
+                throw std::runtime_error("scales out of range.\nprice_decimals + qty_decimals must be between 0 and 16");
+            config.scales[index] = {static_cast<int>(price_decimals), static_cast<int>(qty_decimals)};
+        }
+    }
+    for (int i = 0; i < kTotalExchanges; i++)
+        config.max_book_age_ms[i] = 0.0;
+    simdjson::ondemand::object max_book_age;
+    if (object["max_book_age_ms"].get(max_book_age) == simdjson::SUCCESS) {
+        for (auto age : max_book_age) {
+            int index = getIndex(age.escaped_key(), 1);
+            if (index == -1) throw std::runtime_error("unknown exchange in max_book_age_ms.\narb supported exchanges: okx, derbit, bybit");
+            config.max_book_age_ms[index] = age.value().get_double();
+            if (config.max_book_age_ms[index] < 0)
+                throw std::runtime_error("negative max_book_age_ms.\nuse 0 to disable the age limit of an exchange");
+        }
+    }
     simdjson::ondemand::object fees = object["fees"];
     for (auto fee: fees) {
         int index = getIndex(fee.escaped_key(), 1);
@@ -0,0 +1,148 @@
+#include "work_pool.hpp"
+#include "affinity.hpp"
+
+WorkStealingPool::WorkStealingPool(int helpers, bool busy_poll)
+    : ranges_(new Range[(helpers > 0 ? helpers : 0) + 1]), busy_poll_(busy_poll)
+{
+    for (int i = 0; i < helpers; i++)
+        helpers_.emplace_back(&WorkStealingPool::helperLoop, this, i + 1);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    stop_.store(true, std::memory_order_relaxed);
+    epoch_.fetch_add(1, std::memory_order_release);
+    epoch_.notify_all();
+    for (auto& helper : helpers_)
+        if (helper.joinable())
+            helper.join();
+}
+
+/**
+ * Implementation notes:
+ * - Callback and pending_ are written before the ranges are released, so a
+ *   participant that claims an index also sees the loop it belongs to
+ * - A claim only succeeds on a range tagged with the loop being run, and
+ *   while any index of a loop is unclaimed or running the caller has not
+ *   returned; so a claimed index always runs with its own loop's callback
+ * - The caller returns once pending_ reaches 0, without waiting for
+ *   helpers that never woke up
+ */
+void WorkStealingPool::run(int count, Task task, void* ctx)
+{
+    if (count <= 0)
+        return;
+    const int participants = size();
+    if (participants == 1) {
+        for (int i = 0; i < count; i++)
+            task(ctx, i, 0);
+        return;
+    }
+
+    task_ = task;
+    ctx_ = ctx;
+    pending_.store(count, std::memory_order_relaxed);
+    uint64_t epoch = epoch_.load(std::memory_order_relaxed) + 1;
+    uint64_t tag = epoch & 0xFFFF;
+    for (int w = 0; w < participants; w++) {
+        uint64_t begin = int64_t(count) * w / participants;
+        uint64_t end = int64_t(count) * (w + 1) / participants;
+        ranges_[w].bounds.store(pack(tag, begin, end), std::memory_order_release);
+    }
+    epoch_.store(epoch, std::memory_order_release);
+    if (!busy_poll_)
+        epoch_.notify_all();
+
+    participate(0);
+    while (pending_.load(std::memory_order_acquire) != 0)
+        cpuRelax();
+}
+
+void WorkStealingPool::helperLoop(int worker)
+{
+    uint64_t seen = 0;
+    while (true) {
+        uint64_t epoch = epoch_.load(std::memory_order_acquire);
+        if (epoch == seen) {
+            if (busy_poll_)
+                cpuRelax();
+            else
+                epoch_.wait(seen, std::memory_order_acquire);
+            continue;
+        }
+        seen = epoch;
+        if (stop_.load(std::memory_order_relaxed))
+            return;
+        participate(worker);
+    }
+}
+
+/**
+ * Implementation notes:
+ * - Completed indices are subtracted from pending_ once per participation,
+ *   not once per index, to keep the shared counter off the hot path
+ */
+void WorkStealingPool::participate(int worker)
+{
+    uint64_t tag = epoch_.load(std::memory_order_acquire) & 0xFFFF;
+    int index, done = 0;
+    do {
+        while (takeOwn(worker, tag, index)) {
+            task_(ctx_, index, worker);
+            done++;
+        }
+    } while (steal(worker, tag));
+    if (done > 0)
+        pending_.fetch_sub(done, std::memory_order_acq_rel);
+}
+
+/**
+ * Implementation notes:
+ * - The owner takes from the front and thieves from the back, but both
+ *   CAS the same word, so an index is handed out exactly once
+ */
+bool WorkStealingPool::takeOwn(int worker, uint64_t tag, int& index)
+{
+    std::atomic<uint64_t>& bounds = ranges_[worker].bounds;
+    uint64_t current = bounds.load(std::memory_order_acquire);
+    while (true) {
+        uint64_t begin = beginOf(current), end = endOf(current);
+        if (tagOf(current) != tag || begin >= end)
+            return false;
+        if (bounds.compare_exchange_weak(current, pack(tag, begin + 1, end), std::memory_order_acq_rel)) {
+            index = static_cast<int>(begin);
+            return true;
+        }
+    }
+}
+
+/**
+ * Implementation notes:
+ * - Victims are scanned starting after the thief, so thieves spread out
+ * - Takes the back half (rounded up) of the victim's remaining range and
+ *   installs it as the thief's own range; the thief's range is empty at
+ *   that point, so no other thief can be racing on it, and the loop cannot
+ *   end (and have its ranges reset) while the stolen indices are unrun
+ * - Indices are never reissued within a loop, so a stale range value can
+ *   never match again and the CAS has no ABA problem
+ */
+bool WorkStealingPool::steal(int worker, uint64_t tag)
+{
+    const int participants = size();
+    for (int k = 1; k < participants; k++) {
+        int victim = (worker + k) % participants;
+        std::atomic<uint64_t>& bounds = ranges_[victim].bounds;
+        uint64_t current = bounds.load(std::memory_order_acquire);
+        while (true) {
+            uint64_t begin = beginOf(current), end = endOf(current);
+            if (tagOf(current) != tag || begin >= end)
+                break;
+            uint64_t take = (end - begin + 1) / 2;
+            if (bounds.compare_exchange_weak(current, pack(tag, begin, end - take), std::memory_order_acq_rel)) {
+                ranges_[worker].bounds.store(pack(tag, end - take, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
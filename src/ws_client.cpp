@@ -1,7 +1,7 @@
 #include "ws_client.hpp"
 
+#include <algorithm>
 #include <cstdlib>
-#include <semaphore>
 #include <simdjson.h>
 
 #include <iostream>
@@ -12,33 +12,55 @@
 #include "orderbook.hpp"
 #include "utils.hpp"
 
-using client = websocketpp::client<websocketpp::config::asio_tls_client>;
+using client = websocketpp::client<ArbClientConfig>;
 using context_ptr
     = websocketpp::lib::shared_ptr<websocketpp::lib::asio::ssl::context>;
 
+extern struct Metrics g_metrics;
+
 /**
  * Implementation notes:
  * - Uses WebSocket++ for asynchronous WebSocket communication
  * - Configures TLS for secure connections
  * - Sets up logging and error channels
- * - Initializes perpetual connection mode
+ * - Runs on a shared event loop instead of owning an I/O thread; the pool
+ *   keeps the loop alive, so perpetual mode is not needed
+ * - Uses a TLS socket policy whose TCP layer records kernel receive
+ *   timestamps (see ArbClientConfig)
+ * - Opens <capture_dir>/<exchange>_<BASE>-<QUOTE>.jsonl in append mode
+ *   when payload capture is enabled
  */
-wsClient::wsClient(std::string hostname, bool double_in_string,
-    L2OrderBook& orderbook)
-    : snapshot_(orderbook), double_in_string_(double_in_string)
+wsClient::wsClient(std::string hostname, int exchange, int pair, Scale scale,
+    double max_order_size, PublishedBook& orderbook, BookEventQueue& events,
+    BookEventQueue* cycle_events, IoService& io, bool hw_timestamps, const std::string& capture_dir,
+    BookRecorder* recorder)
+    : exchange_(exchange), pair_(pair), parse_(bookParserFor(exchange)),
+      scale_(scale), max_lots_(toFixed(max_order_size, scale.qty_decimals)),
+      hw_timestamps_(hw_timestamps), snapshot_{}, book_(orderbook), events_(events),
+      cycle_events_(cycle_events), recorder_(recorder)
 {
+    snapshot_.scale = scale_;
+
+    if (!capture_dir.empty()) {
+        std::string pair_name(kPairs[pair]);
+        std::replace(pair_name.begin(), pair_name.end(), '/', '-');
+        std::string path = std::format("{}/{}_{}.jsonl", capture_dir, kExchanges[exchange], pair_name);
+        capture_.open(path, std::ios::app);
+        if (!capture_)
+            std::cerr << "unable to open capture file " << path << "\n";
+    }
+
     uri_ = "wss://" + hostname;
 
     endpoint_.set_access_channels(websocketpp::log::alevel::none);
     endpoint_.set_error_channels(websocketpp::log::elevel::all);
 
-    endpoint_.init_asio();
+    endpoint_.init_asio(&io);
     endpoint_.set_tls_init_handler(websocketpp::lib::bind(
         &wsClient::onTLSInit, this, websocketpp::lib::placeholders::_1));
-    endpoint_.start_perpetual();
-
-    thread_ = websocketpp::lib::make_shared<websocketpp::lib::thread>(
-        &client::run, &endpoint_);
+    endpoint_.set_socket_init_handler(websocketpp::lib::bind(
+        &wsClient::onSocketInit, this, websocketpp::lib::placeholders::_1,
+        websocketpp::lib::placeholders::_2));
 
     initialise(hostname);
 }
@@ -74,22 +96,29 @@ void wsClient::initialise(std::string const& hostname)
         websocketpp::lib::placeholders::_2));
 
     endpoint_.connect(con);
-
-    snapshot_.newData = false;
 }
 
 /**
  * Implementation notes:
- * - Ensures clean shutdown of WebSocket connection
- * - Waits for client thread to complete
+ * - Requests a clean close of the WebSocket connection
+ * - The event loop is owned by IoPool, which is stopped before clients
+ *   are destroyed
  */
 wsClient::~wsClient()
 {
-    endpoint_.stop_perpetual();
     websocketpp::lib::error_code ec;
     endpoint_.close(hdl_, websocketpp::close::status::going_away, "", ec);
+}
 
-    thread_->join();
+/**
+ * Implementation notes:
+ * - The socket is not connected yet; timestamping is switched on by the
+ *   socket itself on its first read
+ */
+void wsClient::onSocketInit(websocketpp::connection_hdl hdl, rx_tls_socket::stream_type& stream)
+{
+    stream.next_layer().setHardwareTimestamps(hw_timestamps_);
+    rx_socket_ = &stream.next_layer();
 }
 
 /**
@@ -105,77 +134,54 @@ void wsClient::onOpen(client* c, websocketpp::connection_hdl hdl)
 
 /**
  * Implementation notes:
- * - Uses simdjson for zero-copy JSON parsing
- * - Handles both string and numeric price/quantity formats
- * - Updates orderbook atomically
- * - Signals processing thread via semaphore
+ * - Uses simdjson for zero-copy JSON parsing; the payload comes from a
+ *   pooled message with SIMDJSON_PADDING spare capacity, so it is parsed
+ *   in place without reallocation
+ * - Parsing is delegated to the parser specialized for this exchange's
+ *   schema at construction, so there are no per-value format branches
+ * - Converts prices and quantities to fixed-point ticks and lots
+ * - Parses into a private snapshot, then hands it to ingestBook(), which
+ *   builds its cumulative arrays once and publishes it through the seqlock
+ *   so readers never observe a half-written book; replay goes through the
+ *   same step
+ * - Announces the published version on the book event queue, and on the
+ *   cycle detector's queue when the pair is a cycle leg; a full queue
+ *   drops the event (counted by the queue) rather than blocking the feed
+ * - The event carries the socket receive timestamp, so detection latency
+ *   includes socket queueing, TLS decryption and websocket framing
  */
 void wsClient::onMessage(websocketpp::connection_hdl hdl, client::message_ptr msg)
 {
     snapshot_.t = std::chrono::high_resolution_clock::now();
+    snapshot_.rxTime = rx_socket_ ? rx_socket_->lastRxTime() : snapshot_.t;
+    if (snapshot_.rxTime < snapshot_.t) {
+        g_metrics.rx_delay_total_us += std::chrono::duration_cast<std::chrono::microseconds>(
+            snapshot_.t - snapshot_.rxTime).count();
+        g_metrics.rx_delay_samples++;
+    }
     simdjson::ondemand::document doc = parser_.iterate(msg->get_raw_payload());
-    simdjson::ondemand::object object = doc.get_object();
-    // std::cout << msg->get_raw_payload() << "\n";
+    parse_(doc, snapshot_);
 
-    simdjson::ondemand::value asks;
-    auto err = doc["asks"].get(asks);
-
-    int i = 0;
-    if (err == simdjson::SUCCESS) {
-        for (auto ask : asks) {
-            int j = 0;
-            for (auto val : ask) {
-                if (j == 0) {
-                    if (double_in_string_) {
-                        snapshot_.askPrice[i] = val.get_double_in_string();
-                    } else {
-                        snapshot_.askPrice[i] = val.get_double();
-                    }
-                    #ifdef FAKE
-                    snapshot_.askPrice[i] -= 1000;
-                    #endif
-                    j++;
-                } else {
-                    if (double_in_string_) {
-                        snapshot_.askQuantity[i] = val.get_double_in_string();
-                    } else {
-                        snapshot_.askQuantity[i] = val.get_double();
-                    }
-                }
-            }
-                i++;
-        }
+    if (!ingestBook(exchange_, pair_, snapshot_, max_lots_, book_, events_, cycle_events_) && !overflow_warned_) {
+        std::cerr << kExchanges[exchange_] << " " << kPairs[pair_]
+                  << ": notional overflows int64, lower the pair's scales\n";
+        overflow_warned_ = true;
     }
-    snapshot_.askSize = i;
 
-    i = 0;
-    simdjson::ondemand::array bids;
-    err = doc["bids"].get(bids);
-    if (err == simdjson::SUCCESS) {
-        for (auto bid : bids) {
-            int j = 0;
-            for (auto val : bid) {
-                if (j == 0) {
-                    if (double_in_string_) {
-                        snapshot_.bidPrice[i] = val.get_double_in_string();
-                    } else {
-                        snapshot_.bidPrice[i] = val.get_double();
-                    }
-                    j++;
-                } else {
-                    if (double_in_string_) {
-                        snapshot_.bidQuantity[i] = val.get_double_in_string();
-                    } else {
-                        snapshot_.bidQuantity[i] = val.get_double();
-                    }
-                }
-            }
-            i++;
+    // Recorded and captured after publishing, off the detection path
+    if (recorder_)
+        recorder_->record(exchange_, pair_, snapshot_);
+    if (capture_.is_open()) {
+        std::string& payload = msg->get_raw_payload();
+        // JSON allows raw newlines only as whitespace, so one line per message is lossless
+        if (payload.find('\n') != std::string::npos) {
+            std::string line = payload;
+            std::replace(line.begin(), line.end(), '\n', ' ');
+            capture_ << line << '\n';
+        } else {
+            capture_ << payload << '\n';
         }
-        snapshot_.bidSize = i;
     }
-    snapshot_.newData = true;
-    sem.release();
 }
 
 /**
@@ -226,9 +232,13 @@ wsClient::onTLSInit(websocketpp::connection_hdl)
  * Implementation notes:
  * - Dynamically constructs WebSocket URLs based on exchange format
  * - Handles connection errors gracefully
- * - Creates unique client instances per exchange/pair
+ * - Creates unique client instances per exchange/pair, each publishing to
+ *   its own (exchange, pair) book and its pair's event queue
+ * - Assigns clients to the pool's event loops round-robin in
+ *   exchange-then-pair order, so the mapping only depends on the config
  */
-void connectToEndpoints(const config& config, std::vector<std::unique_ptr<wsClient>>& clients, std::vector<L2OrderBook>& orderbooks) {
+void connectToEndpoints(const config& config, std::vector<std::unique_ptr<wsClient>>& clients,
+                        std::vector<PairBooks>& markets, IoPool& io_pool, BookRecorder* recorder) {
     for(size_t i = 0; i < kTotalExchanges; i++) {
         if(config.exchanges[i]) {
             for(size_t j = 0; j < kTotalPairs; j++) {
@@ -256,7 +266,10 @@ void connectToEndpoints(const config& config, std::vector<std::unique_ptr<wsClie
                 }          
                 std::cout << "hostname: " << hostname << "\n\n";
                 try {
-                    clients.emplace_back(std::make_unique<wsClient>(hostname, kUseDoubleInString[i], orderbooks[i]));
+                    clients.emplace_back(std::make_unique<wsClient>(hostname, i, j, config.scales[j],
+                        config.max_order_size, markets[j].books[i], markets[j].events,
+                        markets[j].cycle_events, io_pool.next(), config.hw_timestamps,
+                        config.capture_dir, recorder));
                 }
                 catch (std::exception &e) {
                     std::cerr << "unable to connect to endpoint wss://" << hostname << "\nerror: " 
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "backtest.hpp"
+
+namespace {
+
+/// @brief Parses a comma-separated list of numbers, false on any malformed entry
+bool parseList(std::string_view text, std::vector<double>& out) {
+    out.clear();
+    std::stringstream in{std::string(text)};
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        char* end = nullptr;
+        double value = std::strtod(item.c_str(), &end);
+        if (item.empty() || *end != '\0')
+            return false;
+        out.push_back(value);
+    }
+    return !out.empty();
+}
+
+/// @brief Fees of the enabled exchanges of a variant, "okx 0.1 bybit 0.1"
+std::string describeFees(const BacktestVariant& variant, const config& cfg, char sep) {
+    std::ostringstream text;
+    bool first = true;
+    for (int i = 0; i < kTotalExchanges; i++) {
+        if (!cfg.exchanges[i])
+            continue;
+        if (!first)
+            text << sep;
+        text << kExchanges[i] << sep << variant.fees[i];
+        first = false;
+    }
+    return text.str();
+}
+
+void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " [--threads N] [--csv] [--min-profit LIST] [--max-order-size LIST]"
+                 " [--fee LIST] [recording|capture dir]\n"
+                 "  LIST is comma-separated; each --fee value applies to every exchange\n";
+}
+
+}  // namespace
+
+/**
+ * @brief Offline parameter sweep over recorded books
+ *
+ * Usage: arb_backtest [--threads N] [--csv] [--min-profit LIST]
+ *                     [--max-order-size LIST] [--fee LIST] [source]
+ *
+ * Loads a book recording or capture directory (replay.path of config.json
+ * by default) into memory once, then runs the cross product of the given
+ * min_profit, max_order_size and fee values over it on every core. Lists
+ * left out take their single value from config.json, which also selects
+ * the exchanges, pairs, scales, detection mode and book age limits.
+ * Detection goes through runBacktest(), which uses the live depth, pair
+ * selection and VWAP merge code, so a variant equal to the live settings
+ * reports what replay would.
+ *
+ * Prints one row per variant and pair; notional and profit are in the
+ * pair's quote currency.
+ */
+int main(int argc, char** argv) {
+    bool csv = false;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<double> min_profits, max_sizes, fees;
+    std::string source;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        bool ok = true;
+        if (arg == "--csv") {
+            csv = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+            ok = threads > 0;
+        } else if (arg == "--min-profit" && i + 1 < argc) {
+            ok = parseList(argv[++i], min_profits);
+        } else if (arg == "--max-order-size" && i + 1 < argc) {
+            ok = parseList(argv[++i], max_sizes) &&
+                 std::all_of(max_sizes.begin(), max_sizes.end(), [](double v) { return v > 0.0; });
+        } else if (arg == "--fee" && i + 1 < argc) {
+            ok = parseList(argv[++i], fees) &&
+                 std::all_of(fees.begin(), fees.end(), [](double v) { return v >= 0.0; });
+        } else if (!arg.empty() && arg[0] != '-' && source.empty()) {
+            source = arg;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    simdjson::ondemand::parser parser;
+    config cfg{};
+    loadConfig("../config/config.json", cfg, parser);
+    if (source.empty())
+        source = cfg.replay.path;
+    if (source.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Single-value grid axes fall back to the configured settings
+    std::vector<BacktestVariant> variants;
+    if (min_profits.empty())
+        min_profits.push_back(cfg.min_profit);
+    if (max_sizes.empty())
+        max_sizes.push_back(cfg.max_order_size);
+    for (double min_profit : min_profits) {
+        for (double max_size : max_sizes) {
+            BacktestVariant variant{min_profit, max_size, {}};
+            if (fees.empty()) {
+                std::copy_n(cfg.fees, kTotalExchanges, variant.fees);
+                variants.push_back(variant);
+                continue;
+            }
+            for (double fee : fees) {
+                std::fill_n(variant.fees, kTotalExchanges, fee);
+                variants.push_back(variant);
+            }
+        }
+    }
+
+    BookTape tape;
+    auto loading = std::chrono::steady_clock::now();
+    try {
+        ReplayFeed feed;
+        feed.open(source, cfg);
+        loadTape(feed, cfg, tape);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    auto running = std::chrono::steady_clock::now();
+    auto results = runBacktest(tape, cfg, variants, threads);
+    auto finished = std::chrono::steady_clock::now();
+
+    std::cerr << "loaded " << tape.size() << " books (" << tape.skipped << " skipped, "
+              << (tape.prices.size() * (sizeof(Ticks) + sizeof(Lots)) >> 20) << " MB of levels) in "
+              << std::chrono::duration<double>(running - loading).count() << " s; ran "
+              << variants.size() << " variants on " << threads << " threads in "
+              << std::chrono::duration<double>(finished - running).count() << " s\n";
+
+    if (csv)
+        std::cout << "pair,min_profit,max_order_size,fees,updates,opportunities,notional,profit,pairs_pruned,stale_skipped\n";
+    for (int pair = 0; pair < kTotalPairs; pair++) {
+        if (tape.books[pair].empty())
+            continue;
+        if (!csv) {
+            std::cout << "\n" << kPairs[pair] << " (" << tape.books[pair].size() << " books)\n"
+                      << std::left << std::setw(12) << "min_profit" << std::setw(12) << "max_size"
+                      << std::setw(36) << "fees %" << std::right << std::setw(10) << "opps"
+                      << std::setw(18) << "notional" << std::setw(14) << "profit"
+                      << std::setw(10) << "stale" << "\n";
+        }
+        for (size_t v = 0; v < variants.size(); v++) {
+            const BacktestVariant& variant = variants[v];
+            const BacktestResult& r = results[v][pair];
+            if (csv) {
+                std::cout << kPairs[pair] << "," << variant.min_profit << "," << variant.max_order_size << ","
+                          << describeFees(variant, cfg, ' ') << "," << r.updates << "," << r.opportunities << ","
+                          << std::fixed << std::setprecision(6) << r.notional << "," << r.profit
+                          << std::defaultfloat << "," << r.pairs_pruned << "," << r.stale_skipped << "\n";
+            } else {
+                std::cout << std::left << std::setw(12) << variant.min_profit << std::setw(12) << variant.max_order_size
+                          << std::setw(36) << describeFees(variant, cfg, ' ') << std::right
+                          << std::setw(10) << r.opportunities << std::fixed << std::setprecision(2)
+                          << std::setw(18) << r.notional << std::setw(14) << r.profit << std::defaultfloat
+                          << std::setw(10) << r.stale_skipped << "\n";
+            }
+            if (r.overflows > 0)
+                std::cerr << kPairs[pair] << ": max_order_size " << variant.max_order_size
+                          << " overflows int64 notional on " << r.overflows << " books, lower the pair's scales\n";
+        }
+    }
+    return 0;
+}
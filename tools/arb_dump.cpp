@@ -0,0 +1,53 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "journal.hpp"
+
+/**
+ * @brief Renders an opportunity journal as text or CSV
+ *
+ * Usage: arb_dump [--csv] [--from N] [journal]
+ *
+ * Reads the journal written by arb (kJournalPath by default) through a
+ * read-only mapping, so it can run while arb is still appending. Text
+ * output matches the opportunity view of the CLI; CSV output has one row
+ * per record with the columns of formatCsvHeader().
+ */
+int main(int argc, char** argv) {
+    bool csv = false;
+    uint64_t from = 0;
+    std::string path = kJournalPath;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--csv") {
+            csv = true;
+        } else if (arg == "--from" && i + 1 < argc) {
+            from = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!arg.empty() && arg[0] != '-') {
+            path = arg;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--csv] [--from N] [journal]\n";
+            return 1;
+        }
+    }
+
+    JournalReader journal;
+    if (!journal.open(path)) {
+        std::cerr << "cannot read " << path << ": missing, truncated or not a version "
+                  << kJournalVersion << " opportunity journal\n";
+        return 1;
+    }
+
+    if (csv)
+        formatCsvHeader(std::cout);
+    for (uint64_t i = from; i < journal.count(); i++) {
+        if (csv)
+            formatCsv(std::cout, journal, i, journal.record(i));
+        else
+            formatText(std::cout, journal, journal.record(i));
+    }
+    return 0;
+}